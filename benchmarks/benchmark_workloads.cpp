@@ -0,0 +1,294 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file benchmarks/benchmark_workloads.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief End-to-end robot workloads built from the dqpose types
+ *
+ *     This file times whole workloads rather than single operators: the
+ *     forward kinematics and geometric Jacobian of a 7-DoF arm, trajectory
+ *     resampling through pow, point-cloud transforms, lookups in a frame
+ *     tree and the residuals of a pose graph. Every dataset is generated
+ *     from a fixed splitmix64 seed, so runs on any platform see the same
+ *     inputs. Each request is timed on its own, the report gives the
+ *     throughput and the p50 and p99 request latency.
+ *
+ *     Usage: benchmark_workloads [--quick] [workload...]
+ *     An unknown workload name fails the run with exit code 2.
+ *     --quick runs a tenth of the repetitions, enough for a PGO training
+ *     run, see dqpose_PGO in CMakeLists.txt.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dqpose.hpp"
+#include "dqpose/posegraph.hpp"
+#ifdef DQPOSE_USE_LIBRARY
+#include "dqpose/dispatch.hpp"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using namespace dqpose;
+using Clock = std::chrono::steady_clock;
+
+// Random, splitmix64, identical on every platform unlike the std distributions
+class Random {
+    std::uint64_t _state;
+public:
+    explicit Random(const std::uint64_t seed) noexcept : _state( seed ) { }
+    inline std::uint64_t next() noexcept {
+        std::uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    // uniform, in [lo, hi)
+    inline double uniform(const double lo=0, const double hi=1) noexcept {
+        return lo + (hi - lo) * static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+    // pose, a random rotation and a translation in a cube of half side extent
+    inline Posed pose(const double extent) noexcept {
+        const Rotd rotation(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1), uniform(-1, 1));
+        return Posed(rotation, Trand(uniform(-extent, extent), uniform(-extent, extent), uniform(-extent, extent)));
+    }
+};
+
+// Workload, a dataset prepared once and a request run repeatedly, items counts the work of one request
+struct Workload {
+    const char* name;
+    const char* item;
+    std::size_t items;
+    std::size_t requests;
+    std::function<void(std::size_t)> request;
+};
+
+// sink, keeps the results of the requests alive
+volatile double sink = 0;
+
+// run, times every request and prints throughput and latency percentiles
+void run(const Workload& workload, const std::size_t requests) {
+    std::vector<double> latencies(requests);
+    const auto start = Clock::now();
+    for (std::size_t r=0; r<requests; ++r) {
+        const auto begin = Clock::now();
+        workload.request(r);
+        latencies[r] = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+    }
+    const double total = std::chrono::duration<double>(Clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](const double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(p * static_cast<double>(latencies.size())))];
+    };
+    std::printf("%-16s %10zu %14.3e %-10s %12.3f %12.3f\n", workload.name, requests,
+                static_cast<double>(requests * workload.items) / total, workload.item, percentile(0.5), percentile(0.99));
+}
+
+// fk_jacobian, forward kinematics and the 6x7 geometric Jacobian of a Panda-like arm, one configuration per request
+Workload fk_jacobian() {
+    // modified Denavit-Hartenberg link offsets a, d, alpha
+    static const double dh[7][3] = { { 0, 0.333, 0 }, { 0, 0, -M_PI/2 }, { 0, 0.316, M_PI/2 }, { 0.0825, 0, M_PI/2 },
+                                     { -0.0825, 0.384, -M_PI/2 }, { 0, 0, M_PI/2 }, { 0.088, 0, M_PI/2 } };
+    static std::vector<Posed> links;
+    static std::vector<std::array<double, 7>> configurations;
+    links.clear();
+    for (const auto& link : dh) {
+        links.push_back(Posed(Rotd(i_, link[2])) * Posed(Trand(link[0], 0, link[1])));
+    }
+    Random random(43);
+    configurations.resize(4096);
+    for (auto& q : configurations) {
+        for (double& angle : q) angle = random.uniform(-2.8, 2.8);
+    }
+    return { "fk_jacobian", "config/s", 1, 200000, [](const std::size_t r) {
+        const std::array<double, 7>& q = configurations[r % configurations.size()];
+        Posed frames[7];
+        Posed pose;
+        for (int j=0; j<7; ++j) {
+            pose = pose * links[j];
+            frames[j] = pose;
+            pose = pose * Posed(Rotd(k_, q[j]));
+        }
+        const Trand end = pose.translation();
+        double jacobian[6][7];
+        for (int j=0; j<7; ++j) {
+            const Trand z = Trand(0, 0, 1).active_rotated(frames[j].rotation());
+            const Trand p = frames[j].translation();
+            const double d[3] = { end.x() - p.x(), end.y() - p.y(), end.z() - p.z() };
+            jacobian[0][j] = z.y() * d[2] - z.z() * d[1];
+            jacobian[1][j] = z.z() * d[0] - z.x() * d[2];
+            jacobian[2][j] = z.x() * d[1] - z.y() * d[0];
+            jacobian[3][j] = z.x();
+            jacobian[4][j] = z.y();
+            jacobian[5][j] = z.z();
+        }
+        sink = sink + jacobian[0][6] + jacobian[5][0];
+    } };
+}
+
+// resample, a 64 sample window of a keyframe trajectory interpolated by the screw motion pow, one window per request
+Workload resample() {
+    static std::vector<Posed> keyframes;
+    Random random(44);
+    keyframes.assign(1, Posed());
+    for (std::size_t k=1; k<1024; ++k) {
+        const Posed step(Rotd(random.uniform(0.9, 1), random.uniform(-0.1, 0.1), random.uniform(-0.1, 0.1), random.uniform(-0.1, 0.1)),
+                         Trand(random.uniform(0, 0.5), random.uniform(-0.1, 0.1), random.uniform(-0.1, 0.1)));
+        keyframes.push_back(keyframes.back() * step);
+    }
+    return { "resample_pow", "sample/s", 64, 20000, [](const std::size_t r) {
+        const std::size_t first = (r * 7) % (keyframes.size() - 8);
+        double checksum = 0;
+        for (int s=0; s<64; ++s) {
+            const double t = first + s * 0.1;
+            const std::size_t k = static_cast<std::size_t>(t);
+            const UnitDualQuat<double> relative = keyframes[k].conj() * keyframes[k+1];
+            const Posed sample = keyframes[k] * relative.pow(t - static_cast<double>(k));
+            checksum += sample.real().w();
+        }
+        sink = sink + checksum;
+    } };
+}
+
+// point_cloud, a 65536 point float cloud mapped through one of 64 sensor poses, one cloud per request
+Workload point_cloud() {
+    static PureQuatBatchf cloud;
+    static std::vector<Posef> poses;
+    Random random(45);
+    cloud.resize(65536);
+    for (std::size_t i=0; i<cloud.size(); ++i) {
+        const float p[3] = { static_cast<float>(random.uniform(-20, 20)), static_cast<float>(random.uniform(-20, 20)),
+                             static_cast<float>(random.uniform(-2, 2)) };
+        cloud.store(i, p);
+    }
+    poses.clear();
+    for (int k=0; k<64; ++k) poses.push_back(Posef(random.pose(0.05)));
+    return { "point_cloud", "point/s", 65536, 2000, [](const std::size_t r) {
+#ifdef DQPOSE_USE_LIBRARY
+        dispatch::transform(poses[r % poses.size()], cloud);
+#else
+        transform(poses[r % poses.size()], cloud);
+#endif
+        sink = sink + cloud.data(0)[r % cloud.size()];
+    } };
+}
+
+// frame_tree, the relative pose between two frames of a 1024 frame tree found through their root paths, one lookup per request
+Workload frame_tree() {
+    static std::vector<std::size_t> parents;
+    static std::vector<Posed> locals;
+    static std::vector<std::pair<std::size_t, std::size_t>> queries;
+    Random random(46);
+    parents.assign(1, 0);
+    locals.assign(1, Posed());
+    for (std::size_t f=1; f<1024; ++f) {
+        // parents drawn from the last 32 frames give trees about 32 levels deep
+        parents.push_back(f - 1 - static_cast<std::size_t>(random.uniform(0, static_cast<double>(std::min<std::size_t>(f, 32)))));
+        locals.push_back(random.pose(1));
+    }
+    queries.resize(4096);
+    for (auto& query : queries) {
+        query = { static_cast<std::size_t>(random.uniform(0, 1024)), static_cast<std::size_t>(random.uniform(0, 1024)) };
+    }
+    return { "frame_tree", "lookup/s", 1, 200000, [](const std::size_t r) {
+        const auto [from, to] = queries[r % queries.size()];
+        const auto root_pose = [](std::size_t frame) {
+            Posed pose;
+            for (; frame != 0; frame = parents[frame]) pose = locals[frame] * pose;
+            return pose;
+        };
+        const Posed relative = root_pose(from).conj() * root_pose(to);
+        sink = sink + relative.dual().x();
+    } };
+}
+
+// pose_graph, every residual of a 2000 node graph with odometry and loop closure edges, one sweep per request
+Workload pose_graph() {
+    static PoseGraph<double> graph;
+    Random random(47);
+    graph = PoseGraph<double>();
+    std::vector<Posed> truth(1, Posed());
+    for (std::size_t n=1; n<2000; ++n) {
+        truth.push_back(truth.back() * Posed(Rotd(k_, random.uniform(-0.2, 0.2)), Trand(1, random.uniform(-0.1, 0.1), 0)));
+    }
+    for (const Posed& pose : truth) {
+        graph.add_node(Posed(pose * random.pose(0.05)), graph.node_count() == 0);
+    }
+    for (std::size_t n=1; n<truth.size(); ++n) {
+        graph.add_edge(n - 1, n, Posed(truth[n-1].conj() * truth[n]));
+    }
+    for (int c=0; c<4000; ++c) {
+        const std::size_t from = static_cast<std::size_t>(random.uniform(0, 1990));
+        const std::size_t to = from + 1 + static_cast<std::size_t>(random.uniform(0, 9));
+        graph.add_edge(from, to, Posed(truth[from].conj() * truth[to]));
+    }
+    return { "pose_graph", "edge/s", graph.edge_count(), 500, [](const std::size_t) {
+        double checksum = 0;
+        for (std::size_t e=0; e<graph.edge_count(); ++e) checksum += graph.residual(e)[0];
+        sink = sink + checksum;
+    } };
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    std::vector<std::string> selected;
+    for (int a=1; a<argc; ++a) {
+        if (std::strcmp(argv[a], "--quick") == 0) quick = true;
+        else selected.push_back(argv[a]);
+    }
+    const std::vector<std::pair<std::string, std::function<Workload()>>> workloads = {
+        { "fk_jacobian", fk_jacobian }, { "resample_pow", resample }, { "point_cloud", point_cloud },
+        { "frame_tree", frame_tree }, { "pose_graph", pose_graph } };
+    // a mistyped name would otherwise run nothing, and a PGO training run would train nothing
+    for (const auto& name : selected) {
+        const bool known = std::any_of(workloads.begin(), workloads.end(), [&](const auto& workload) { return workload.first == name; });
+        if (!known) {
+            std::fprintf(stderr, "Unknown workload %s.\nUsage: %s [--quick] [workload...], workloads:", name.c_str(), argv[0]);
+            for (const auto& workload : workloads) std::fprintf(stderr, " %s", workload.first.c_str());
+            std::fprintf(stderr, "\n");
+            return 2;
+        }
+    }
+
+#ifdef DQPOSE_USE_LIBRARY
+    std::printf("dispatch: %s\n", isa_name(active_isa()));
+#endif
+    std::printf("%-16s %10s %14s %-10s %12s %12s\n", "workload", "requests", "throughput", "", "p50 [us]", "p99 [us]");
+    for (const auto& [name, make] : workloads) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), name) == selected.end()) continue;
+        const Workload workload = make();
+        run(workload, quick ? workload.requests / 10 : workload.requests);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file examples/example_skinning.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ */
+
+#include "dqpose.hpp"
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+// rotation about z by degrees, as a dual quaternion of either sign
+dqpose::DualQuatd rotation_z(const double degrees, const double sign=1) {
+    const double half = degrees * std::numbers::pi / 360;
+    return dqpose::DualQuatd(sign * std::cos(half), 0, 0, sign * std::sin(half), 0, 0, 0, 0);
+}
+
+int main() {
+using namespace dqpose;
+    DualQuatBatchd bones;
+    bones.push_back(rotation_z(176));        // 0, unrelated to the vertex
+    bones.push_back(rotation_z(10));         // 1
+    bones.push_back(rotation_z(-20, -1));    // 2, stored with a negative scalar part
+    PureQuatBatchd positions;
+    positions.push_back(PureQuatd(1, 0, 0));
+    PureQuatBatchd out;
+
+    // Slot 0 carries no weight, the blend must follow the weighted bones 1 and 2 only,
+    // a rotation of -5 degrees, whatever bone the empty slot still names
+    SkinInfluencesd influences(1, 3);
+    influences.set(0, 0, 0, 0.0);
+    influences.set(0, 1, 1, 0.5);
+    influences.set(0, 2, 2, 0.5);
+    skin(bones, influences, positions, out);
+    const PureQuatd p = out.get(0);
+    const double angle = std::atan2(p.y(), p.x()) * 180 / std::numbers::pi;
+    std::cout << "Skinned by bones 1 and 2, slot 0 empty  : " << p << ", rotated by " << angle << " degrees\n";
+    if (std::abs(angle + 5) > 1e-9) {
+        std::cout << "  - expected -5 degrees\n";
+        return 1;
+    }
+
+    // A stale bone index in an empty slot is still out of range
+    influences.set(0, 0, 1000000, 0.0);
+    try {
+        skin(bones, influences, positions, out);
+        std::cout << "Stale bone index in an empty slot       : accepted\n";
+        return 1;
+    } catch (const std::runtime_error& e) {
+        std::cout << "Stale bone index in an empty slot       : " << e.what() << "\n";
+    }
+}
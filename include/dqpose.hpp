@@ -31,7 +31,28 @@
  */
 
 #pragma once
+#include "dqpose/half.hpp"
 #include "dqpose/quat.hpp"
 #include "dqpose/dualquat.hpp"
 #include "dqpose/pose.hpp"
+#include "dqpose/batch.hpp"
+#include "dqpose/chain.hpp"
+#include "dqpose/parallel.hpp"
+#include "dqpose/linalg.hpp"
+#include "dqpose/posegraph.hpp"
+#include "dqpose/calibration.hpp"
+#include "dqpose/registration.hpp"
+#include "dqpose/skinning.hpp"
 
+#include "dqpose/stream.hpp"
+#include "dqpose/integrator.hpp"
+#include "dqpose/metrics.hpp"
+#include "dqpose/spatial.hpp"
+#include "dqpose/sampling.hpp"
+#include "dqpose/pipeline.hpp"
+// POSIX shared memory
+#if defined(__unix__) || defined(__APPLE__)
+#include "dqpose/shm.hpp"
+#endif
+#include "dqpose/format.hpp"
+#include "dqpose/trace.hpp"
@@ -0,0 +1,552 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/batch.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining batch containers of Quaternions
+ *
+ *     This file provides structure-of-arrays containers holding many
+ *     Quaternions or Dual Quaternions. Elements are kept as bare scalars,
+ *     one array per component, and are converted to the requested scalar
+ *     type on access, so a batch can be stored in a narrow type and
+ *     processed in a wide one, down to the 16-bit Half and BFloat16.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "quat.hpp"
+#include "dualquat.hpp"
+#include "kernel.hpp"
+#include "trace_macros.hpp"
+#include <vector>
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace dqpose
+{
+
+template<QuatScalar qScalar>
+class QuatBatch;
+template<QuatScalar qScalar>
+class PureQuatBatch;
+template<QuatScalar qScalar>
+class DualQuatBatch;
+
+template<QuatScalar qScalar>
+class QuatBatch {
+protected:
+    std::array<std::vector<qScalar>, 4> _data;
+public:
+    // Default Constructor
+    explicit QuatBatch() noexcept
+        : _data{ } {
+
+    }
+    // Size Constructor
+    explicit QuatBatch(const std::size_t size)
+        : _data{ } {
+        resize(size);
+    }
+    // size
+    inline std::size_t size() const noexcept { return _data[0].size(); }
+    inline bool empty() const noexcept { return _data[0].empty(); }
+    // reserve
+    inline void reserve(const std::size_t size) {
+        for (auto& component : _data) component.reserve(size);
+    }
+    // resize
+    inline void resize(const std::size_t size) {
+        for (auto& component : _data) component.resize(size);
+    }
+    // clear
+    inline void clear() noexcept {
+        for (auto& component : _data) component.clear();
+    }
+    // push_back
+    template<typename Scalar>
+    inline void push_back(const Quat<Scalar>& quat) {
+        _data[0].push_back(static_cast<qScalar>(quat.w()));
+        _data[1].push_back(static_cast<qScalar>(quat.x()));
+        _data[2].push_back(static_cast<qScalar>(quat.y()));
+        _data[3].push_back(static_cast<qScalar>(quat.z()));
+    }
+    // load, writes the i-th element into 4 scalars of any type
+    template<typename Scalar>
+    inline void load(const std::size_t i, Scalar* arr4) const noexcept {
+        for (int k=0; k<4; ++k) arr4[k] = static_cast<Scalar>(_data[k][i]);
+    }
+    // store, reads the i-th element from 4 scalars of any type
+    template<typename Scalar>
+    inline void store(const std::size_t i, const Scalar* arr4) noexcept {
+        for (int k=0; k<4; ++k) _data[k][i] = static_cast<qScalar>(arr4[k]);
+    }
+    // get
+    template<typename Scalar=qScalar>
+    inline Quat<Scalar> get(const std::size_t i) const noexcept {
+        return Quat<Scalar>(static_cast<Scalar>(_data[0][i]), static_cast<Scalar>(_data[1][i]),
+                            static_cast<Scalar>(_data[2][i]), static_cast<Scalar>(_data[3][i]));
+    }
+    // set
+    template<typename Scalar>
+    inline void set(const std::size_t i, const Quat<Scalar>& quat) noexcept {
+        store(i, quat.data());
+    }
+    // data, the k-th component array, w x y z
+    inline qScalar* data(const int k) noexcept { return _data[k].data(); }
+    inline const qScalar* data(const int k) const noexcept { return _data[k].data(); }
+};
+
+template<QuatScalar qScalar>
+class PureQuatBatch {
+protected:
+    std::array<std::vector<qScalar>, 3> _data;
+public:
+    // Default Constructor
+    explicit PureQuatBatch() noexcept
+        : _data{ } {
+
+    }
+    // Size Constructor
+    explicit PureQuatBatch(const std::size_t size)
+        : _data{ } {
+        resize(size);
+    }
+    // size
+    inline std::size_t size() const noexcept { return _data[0].size(); }
+    inline bool empty() const noexcept { return _data[0].empty(); }
+    // reserve
+    inline void reserve(const std::size_t size) {
+        for (auto& component : _data) component.reserve(size);
+    }
+    // resize
+    inline void resize(const std::size_t size) {
+        for (auto& component : _data) component.resize(size);
+    }
+    // clear
+    inline void clear() noexcept {
+        for (auto& component : _data) component.clear();
+    }
+    // push_back
+    template<typename Scalar>
+    inline void push_back(const Quat<Scalar>& quat) {
+        _data[0].push_back(static_cast<qScalar>(quat.x()));
+        _data[1].push_back(static_cast<qScalar>(quat.y()));
+        _data[2].push_back(static_cast<qScalar>(quat.z()));
+    }
+    // load, writes the i-th element into 3 scalars of any type
+    template<typename Scalar>
+    inline void load(const std::size_t i, Scalar* arr3) const noexcept {
+        for (int k=0; k<3; ++k) arr3[k] = static_cast<Scalar>(_data[k][i]);
+    }
+    // store, reads the i-th element from 3 scalars of any type
+    template<typename Scalar>
+    inline void store(const std::size_t i, const Scalar* arr3) noexcept {
+        for (int k=0; k<3; ++k) _data[k][i] = static_cast<qScalar>(arr3[k]);
+    }
+    // get
+    template<typename Scalar=qScalar>
+    inline PureQuat<Scalar> get(const std::size_t i) const noexcept {
+        return PureQuat<Scalar>(static_cast<Scalar>(_data[0][i]), static_cast<Scalar>(_data[1][i]), static_cast<Scalar>(_data[2][i]));
+    }
+    // set
+    template<typename Scalar>
+    inline void set(const std::size_t i, const Quat<Scalar>& quat) noexcept {
+        store(i, quat.data() + 1);
+    }
+    // data, the k-th component array, x y z
+    inline qScalar* data(const int k) noexcept { return _data[k].data(); }
+    inline const qScalar* data(const int k) const noexcept { return _data[k].data(); }
+};
+
+template<QuatScalar qScalar>
+class DualQuatBatch {
+protected:
+    std::array<std::vector<qScalar>, 8> _data;
+public:
+    // Default Constructor
+    explicit DualQuatBatch() noexcept
+        : _data{ } {
+
+    }
+    // Size Constructor
+    explicit DualQuatBatch(const std::size_t size)
+        : _data{ } {
+        resize(size);
+    }
+    // size
+    inline std::size_t size() const noexcept { return _data[0].size(); }
+    inline bool empty() const noexcept { return _data[0].empty(); }
+    // reserve
+    inline void reserve(const std::size_t size) {
+        for (auto& component : _data) component.reserve(size);
+    }
+    // resize
+    inline void resize(const std::size_t size) {
+        for (auto& component : _data) component.resize(size);
+    }
+    // clear
+    inline void clear() noexcept {
+        for (auto& component : _data) component.clear();
+    }
+    // push_back
+    template<typename Scalar>
+    inline void push_back(const DualQuat<Scalar>& dq) {
+        const Quat<Scalar> real = dq.real();
+        const Quat<Scalar> dual = dq.dual();
+        for (int k=0; k<4; ++k) {
+            _data[k].push_back(static_cast<qScalar>(real.data()[k]));
+            _data[k+4].push_back(static_cast<qScalar>(dual.data()[k]));
+        }
+    }
+    // load, writes the i-th element into 8 scalars of any type
+    template<typename Scalar>
+    inline void load(const std::size_t i, Scalar* arr8) const noexcept {
+        for (int k=0; k<8; ++k) arr8[k] = static_cast<Scalar>(_data[k][i]);
+    }
+    // store, reads the i-th element from 8 scalars of any type
+    template<typename Scalar>
+    inline void store(const std::size_t i, const Scalar* arr8) noexcept {
+        for (int k=0; k<8; ++k) _data[k][i] = static_cast<qScalar>(arr8[k]);
+    }
+    // get
+    template<typename Scalar=qScalar>
+    inline DualQuat<Scalar> get(const std::size_t i) const noexcept {
+        std::array<Scalar, 8> arr8;
+        load(i, arr8.data());
+        return DualQuat<Scalar>(arr8);
+    }
+    // set
+    template<typename Scalar>
+    inline void set(const std::size_t i, const DualQuat<Scalar>& dq) noexcept {
+        const Quat<Scalar> real = dq.real();
+        const Quat<Scalar> dual = dq.dual();
+        for (int k=0; k<4; ++k) {
+            _data[k][i] = static_cast<qScalar>(real.data()[k]);
+            _data[k+4][i] = static_cast<qScalar>(dual.data()[k]);
+        }
+    }
+    // data, the k-th component array, real w x y z then dual w x y z
+    inline qScalar* data(const int k) noexcept { return _data[k].data(); }
+    inline const qScalar* data(const int k) const noexcept { return _data[k].data(); }
+};
+
+// convert, element-wise conversion of a whole batch, e.g. Half storage to float
+template<typename dScalar, typename sScalar>
+inline void convert(const QuatBatch<sScalar>& src, QuatBatch<dScalar>& dst) {
+    dst.resize(src.size());
+    for (int k=0; k<4; ++k) kernel::convert(src.data(k), dst.data(k), src.size());
+}
+// convert, element-wise conversion of a whole batch, e.g. Half storage to float
+template<typename dScalar, typename sScalar>
+inline void convert(const PureQuatBatch<sScalar>& src, PureQuatBatch<dScalar>& dst) {
+    dst.resize(src.size());
+    for (int k=0; k<3; ++k) kernel::convert(src.data(k), dst.data(k), src.size());
+}
+// convert, element-wise conversion of a whole batch, e.g. Half storage to float
+template<typename dScalar, typename sScalar>
+inline void convert(const DualQuatBatch<sScalar>& src, DualQuatBatch<dScalar>& dst) {
+    dst.resize(src.size());
+    for (int k=0; k<8; ++k) kernel::convert(src.data(k), dst.data(k), src.size());
+}
+
+// active_rotate, rotates every vector by the unit Quaternion rotation
+template<typename qScalar, typename Scalar>
+inline void active_rotate(const Quat<qScalar>& rotation, PureQuatBatch<Scalar>& vectors) noexcept {
+    Scalar* x = vectors.data(0);
+    Scalar* y = vectors.data(1);
+    Scalar* z = vectors.data(2);
+    const Scalar q[4] = { static_cast<Scalar>(rotation.w()), static_cast<Scalar>(rotation.x()),
+                          static_cast<Scalar>(rotation.y()), static_cast<Scalar>(rotation.z()) };
+    for (std::size_t i=0; i<vectors.size(); ++i) {
+        Scalar v[3] = { x[i], y[i], z[i] };
+        kernel::quat_rotate(q, v, v);
+        x[i] = v[0]; y[i] = v[1]; z[i] = v[2];
+    }
+}
+// passive_rotate, rotates every vector by the conjugate of the unit Quaternion rotation
+template<typename qScalar, typename Scalar>
+inline void passive_rotate(const Quat<qScalar>& rotation, PureQuatBatch<Scalar>& vectors) noexcept {
+    active_rotate(rotation.conj(), vectors);
+}
+// active_rotate, rotates the i-th vector by the i-th unit Quaternion
+template<typename qScalar, typename Scalar>
+inline void active_rotate(const QuatBatch<qScalar>& rotations, PureQuatBatch<Scalar>& vectors) noexcept {
+    const qScalar* q_w = rotations.data(0);
+    const qScalar* q_x = rotations.data(1);
+    const qScalar* q_y = rotations.data(2);
+    const qScalar* q_z = rotations.data(3);
+    Scalar* x = vectors.data(0);
+    Scalar* y = vectors.data(1);
+    Scalar* z = vectors.data(2);
+    for (std::size_t i=0; i<vectors.size(); ++i) {
+        const Scalar q[4] = { static_cast<Scalar>(q_w[i]), static_cast<Scalar>(q_x[i]), static_cast<Scalar>(q_y[i]), static_cast<Scalar>(q_z[i]) };
+        Scalar v[3] = { x[i], y[i], z[i] };
+        kernel::quat_rotate(q, v, v);
+        x[i] = v[0]; y[i] = v[1]; z[i] = v[2];
+    }
+}
+// passive_rotate, rotates the i-th vector by the conjugate of the i-th unit Quaternion
+template<typename qScalar, typename Scalar>
+inline void passive_rotate(const QuatBatch<qScalar>& rotations, PureQuatBatch<Scalar>& vectors) noexcept {
+    const qScalar* q_w = rotations.data(0);
+    const qScalar* q_x = rotations.data(1);
+    const qScalar* q_y = rotations.data(2);
+    const qScalar* q_z = rotations.data(3);
+    Scalar* x = vectors.data(0);
+    Scalar* y = vectors.data(1);
+    Scalar* z = vectors.data(2);
+    for (std::size_t i=0; i<vectors.size(); ++i) {
+        const Scalar q[4] = { static_cast<Scalar>(q_w[i]), static_cast<Scalar>(q_x[i]), static_cast<Scalar>(q_y[i]), static_cast<Scalar>(q_z[i]) };
+        Scalar v[3] = { x[i], y[i], z[i] };
+        kernel::quat_inverse_rotate(q, v, v);
+        x[i] = v[0]; y[i] = v[1]; z[i] = v[2];
+    }
+}
+// transform, maps every point through the unit Dual Quaternion pose, p' = r p r* + t
+template<typename qScalar, typename Scalar>
+inline void transform(const DualQuat<qScalar>& pose, PureQuatBatch<Scalar>& points) noexcept {
+    DQPOSE_TRACE_SCOPE("dqpose::transform");
+    const std::array<qScalar, 8> dq = pose.array();
+    Scalar t[3];
+    kernel::dualquat_translation(dq.data(), t);
+    const Scalar q[4] = { static_cast<Scalar>(dq[0]), static_cast<Scalar>(dq[1]), static_cast<Scalar>(dq[2]), static_cast<Scalar>(dq[3]) };
+    Scalar* x = points.data(0);
+    Scalar* y = points.data(1);
+    Scalar* z = points.data(2);
+    for (std::size_t i=0; i<points.size(); ++i) {
+        Scalar v[3] = { x[i], y[i], z[i] };
+        kernel::quat_rotate(q, v, v);
+        x[i] = v[0] + t[0]; y[i] = v[1] + t[1]; z[i] = v[2] + t[2];
+    }
+}
+
+// screw_log, the screw logarithm of every unit Dual Quaternion, written as the real and dual vector parts of the pure results
+template<typename Scalar, typename qScalar>
+inline void screw_log(const DualQuatBatch<qScalar>& poses, PureQuatBatch<Scalar>& real, PureQuatBatch<Scalar>& dual) {
+    DQPOSE_TRACE_SCOPE("dqpose::screw_log");
+    using cScalar = std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>;
+    real.resize(poses.size());
+    dual.resize(poses.size());
+    for (std::size_t i=0; i<poses.size(); ++i) {
+        cScalar dq[8], v6[6];
+        poses.load(i, dq);
+        kernel::unit_dualquat_log(dq, v6);
+        real.store(i, v6);
+        dual.store(i, v6 + 3);
+    }
+}
+// screw_exp, the screw exponential of every pure Dual Quaternion given by its real and dual vector parts, inverse of screw_log
+template<typename qScalar, typename Scalar>
+inline void screw_exp(const PureQuatBatch<Scalar>& real, const PureQuatBatch<Scalar>& dual, DualQuatBatch<qScalar>& poses) {
+    DQPOSE_TRACE_SCOPE("dqpose::screw_exp");
+    using cScalar = std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>;
+    if (real.size() != dual.size()) {
+        throw std::runtime_error("Error: screw_exp() Real and dual batches differ in size.");
+    }
+    poses.resize(real.size());
+    for (std::size_t i=0; i<real.size(); ++i) {
+        cScalar v6[6], dq[8];
+        real.load(i, v6);
+        dual.load(i, v6 + 3);
+        kernel::pure_dualquat_exp(v6, dq);
+        poses.store(i, dq);
+    }
+}
+
+// to_matrices, writes the 3x3 rotation matrix of every element, 9 scalars each
+template<typename Scalar, typename qScalar>
+inline void to_matrices(const QuatBatch<qScalar>& batch, Scalar* mats, const MatrixLayout layout=MatrixLayout::RowMajor) noexcept {
+    std::size_t row_stride, col_stride;
+    kernel::matrix_strides(layout, 3, row_stride, col_stride);
+    const qScalar* w = batch.data(0);
+    const qScalar* x = batch.data(1);
+    const qScalar* y = batch.data(2);
+    const qScalar* z = batch.data(3);
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        const Scalar q[4] = { static_cast<Scalar>(w[i]), static_cast<Scalar>(x[i]), static_cast<Scalar>(y[i]), static_cast<Scalar>(z[i]) };
+        kernel::quat_to_matrix(q, mats + 9*i, row_stride, col_stride);
+    }
+}
+// from_matrices, reads size 3x3 rotation matrices into unit Quaternions
+template<typename qScalar, typename Scalar>
+inline void from_matrices(const Scalar* mats, const std::size_t size, QuatBatch<qScalar>& batch, const MatrixLayout layout=MatrixLayout::RowMajor) {
+    std::size_t row_stride, col_stride;
+    kernel::matrix_strides(layout, 3, row_stride, col_stride);
+    batch.resize(size);
+    for (std::size_t i=0; i<size; ++i) {
+        Scalar q[4];
+        kernel::matrix_to_quat(mats + 9*i, q, row_stride, col_stride);
+        const Scalar inv_norm = 1 / std::sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+        for (int k=0; k<4; ++k) q[k] *= inv_norm;
+        batch.store(i, q);
+    }
+}
+// to_matrices, writes the 4x4 homogeneous transform of every element, 16 scalars each
+template<typename Scalar, typename qScalar>
+inline void to_matrices(const DualQuatBatch<qScalar>& batch, Scalar* mats, const MatrixLayout layout=MatrixLayout::RowMajor) noexcept {
+    std::size_t row_stride, col_stride;
+    kernel::matrix_strides(layout, 4, row_stride, col_stride);
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        Scalar dq[8];
+        batch.load(i, dq);
+        kernel::dualquat_to_matrix(dq, mats + 16*i, row_stride, col_stride);
+    }
+}
+// from_matrices, reads size 4x4 homogeneous transforms into unit Dual Quaternions
+template<typename qScalar, typename Scalar>
+inline void from_matrices(const Scalar* mats, const std::size_t size, DualQuatBatch<qScalar>& batch, const MatrixLayout layout=MatrixLayout::RowMajor) {
+    std::size_t row_stride, col_stride;
+    kernel::matrix_strides(layout, 4, row_stride, col_stride);
+    batch.resize(size);
+    for (std::size_t i=0; i<size; ++i) {
+        Scalar dq[8];
+        kernel::matrix_to_dualquat(mats + 16*i, dq, row_stride, col_stride);
+        batch.store(i, dq);
+    }
+}
+
+
+// normalize, scales every element to |q| = 1, see NormalizeMethod, elements of norm 0 are not unit afterwards
+template<typename Scalar>
+inline void normalize(QuatBatch<Scalar>& batch, const NormalizeMethod method=NormalizeMethod::Exact) noexcept {
+    using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+    DQPOSE_TRACE_SCOPE("dqpose::normalize");
+    Scalar* const data[4] = { batch.data(0), batch.data(1), batch.data(2), batch.data(3) };
+    kernel::normalize_soa<4, cScalar>(data, batch.size(), method);
+}
+// normalize, projects every element onto the unit Dual Quaternions like kernel::dualquat_renormalize, see NormalizeMethod,
+// elements with a real part of norm 0 are not unit afterwards
+template<typename Scalar>
+inline void normalize(DualQuatBatch<Scalar>& batch, const NormalizeMethod method=NormalizeMethod::Exact) noexcept {
+    using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+    DQPOSE_TRACE_SCOPE("dqpose::normalize");
+    Scalar* data[8];
+    for (int k=0; k<8; ++k) data[k] = batch.data(k);
+    kernel::normalize_soa<8, cScalar>(data, batch.size(), method);
+}
+
+// unit_errors, squared deviation of every element from |q| = 1, (|q|^2 - 1)^2
+template<typename qScalar, typename Scalar>
+inline void unit_errors(const QuatBatch<Scalar>& batch, qScalar* errors) noexcept {
+    const Scalar* w = batch.data(0);
+    const Scalar* x = batch.data(1);
+    const Scalar* y = batch.data(2);
+    const Scalar* z = batch.data(3);
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        const qScalar norm2 = square(static_cast<qScalar>(w[i])) + square(static_cast<qScalar>(x[i]))
+                            + square(static_cast<qScalar>(y[i])) + square(static_cast<qScalar>(z[i]));
+        errors[i] = (norm2 - 1) * (norm2 - 1);
+    }
+}
+// unit_errors, squared deviation of every element from the unit constraints, see DualQuat::unit_error
+template<typename qScalar, typename Scalar>
+inline void unit_errors(const DualQuatBatch<Scalar>& batch, qScalar* errors) noexcept {
+    const Scalar* data[8];
+    for (int k=0; k<8; ++k) data[k] = batch.data(k);
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        qScalar real_norm2 = 0, real_dot_dual = 0;
+        for (int k=0; k<4; ++k) {
+            const qScalar r = static_cast<qScalar>(data[k][i]);
+            real_norm2 += r * r;
+            real_dot_dual += r * static_cast<qScalar>(data[k+4][i]);
+        }
+        errors[i] = (real_norm2 - 1) * (real_norm2 - 1) + real_dot_dual * real_dot_dual;
+    }
+}
+// unit_mask, mask[i] = 1 when the i-th element is a unit Quaternion within the squared tolerance, 0 otherwise and for NaN,
+// returns the number of unit elements
+template<typename Scalar, typename cScalar=std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>>
+inline std::size_t unit_mask(const QuatBatch<Scalar>& batch, std::uint8_t* mask,
+                             const cScalar tolerance=64*std::numeric_limits<cScalar>::epsilon()) noexcept {
+    const Scalar* w = batch.data(0);
+    const Scalar* x = batch.data(1);
+    const Scalar* y = batch.data(2);
+    const Scalar* z = batch.data(3);
+    std::size_t count = 0;
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        const cScalar norm2 = square(static_cast<cScalar>(w[i])) + square(static_cast<cScalar>(x[i]))
+                            + square(static_cast<cScalar>(y[i])) + square(static_cast<cScalar>(z[i]));
+        mask[i] = (norm2 - 1) * (norm2 - 1) <= tolerance;
+        count += mask[i];
+    }
+    return count;
+}
+// unit_mask, mask[i] = 1 when the i-th element is a unit Dual Quaternion within the squared tolerance, 0 otherwise and for NaN,
+// returns the number of unit elements
+template<typename Scalar, typename cScalar=std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>>
+inline std::size_t unit_mask(const DualQuatBatch<Scalar>& batch, std::uint8_t* mask,
+                             const cScalar tolerance=64*std::numeric_limits<cScalar>::epsilon()) noexcept {
+    const Scalar* data[8];
+    for (int k=0; k<8; ++k) data[k] = batch.data(k);
+    std::size_t count = 0;
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        cScalar real_norm2 = 0, real_dot_dual = 0;
+        for (int k=0; k<4; ++k) {
+            const cScalar r = static_cast<cScalar>(data[k][i]);
+            real_norm2 += r * r;
+            real_dot_dual += r * static_cast<cScalar>(data[k+4][i]);
+        }
+        mask[i] = (real_norm2 - 1) * (real_norm2 - 1) + real_dot_dual * real_dot_dual <= tolerance;
+        count += mask[i];
+    }
+    return count;
+}
+// unit_mask, as a vector
+template<typename Batch>
+inline std::vector<std::uint8_t> unit_mask(const Batch& batch) {
+    std::vector<std::uint8_t> res(batch.size());
+    unit_mask(batch, res.data());
+    return res;
+}
+
+using QuatBatchf = QuatBatch<float>;
+using PureQuatBatchf = PureQuatBatch<float>;
+using DualQuatBatchf = DualQuatBatch<float>;
+using QuatBatchd = QuatBatch<double>;
+using PureQuatBatchd = PureQuatBatch<double>;
+using DualQuatBatchd = DualQuatBatch<double>;
+using QuatBatchld = QuatBatch<long double>;
+using PureQuatBatchld = PureQuatBatch<long double>;
+using DualQuatBatchld = DualQuatBatch<long double>;
+using QuatBatchh = QuatBatch<Half>;
+using PureQuatBatchh = PureQuatBatch<Half>;
+using DualQuatBatchh = DualQuatBatch<Half>;
+using QuatBatchbf = QuatBatch<BFloat16>;
+using PureQuatBatchbf = PureQuatBatch<BFloat16>;
+using DualQuatBatchbf = DualQuatBatch<BFloat16>;
+
+#ifdef DQPOSE_USE_LIBRARY
+// instantiated once in the dqpose library, see src/dqpose.cpp
+#define DQPOSE_EXTERN_BATCH(Scalar) \
+    extern template class QuatBatch<Scalar>; \
+    extern template class PureQuatBatch<Scalar>; \
+    extern template class DualQuatBatch<Scalar>;
+DQPOSE_EXTERN_BATCH(float)
+DQPOSE_EXTERN_BATCH(double)
+DQPOSE_EXTERN_BATCH(long double)
+#undef DQPOSE_EXTERN_BATCH
+#endif
+
+}  // namespace dqpose
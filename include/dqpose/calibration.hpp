@@ -0,0 +1,297 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/calibration.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining hand-eye calibration
+ *
+ *     This file provides hand_eye, which solves A_i X = X B_i for the
+ *     unknown Pose X given pairs of relative motions, A_i of the hand and
+ *     B_i of the eye. The linear step is the Daniilidis method: every pair
+ *     gives (hamiplus(A_i) - haminus(B_i)) x = 0, the 8x8 normal matrix of
+ *     all pairs is accumulated on parallel_reduce, and x is the unit
+ *     combination of its two smallest eigenvectors. Gauss-Newton then
+ *     refines X on the residuals log(X^-1 A_i X B_i^-1).
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace dqpose
+{
+
+template<typename qScalar>
+class HandEyeOptions {
+public:
+    // refine the linear solution with Gauss-Newton
+    bool refine = true;
+    // Gauss-Newton iterations
+    std::size_t max_iterations = 20;
+    // stop once the relative error decrease falls below
+    qScalar tolerance = qScalar(1e-12);
+    // worker threads, 0 uses every hardware thread
+    std::size_t threads = 0;
+};
+
+template<QuatScalar qScalar>
+class HandEyeResult {
+public:
+    Pose<qScalar> pose = Pose<qScalar>();
+    // 0.5 sum of squared residual norms after the linear step and after the refinement
+    qScalar linear_error = 0;
+    qScalar final_error = 0;
+    std::size_t iterations = 0;
+};
+
+namespace kernel
+{
+
+// hand_eye_residual, tangent of x* a x b*, on the positive real hemisphere
+template<typename qScalar>
+constexpr inline void hand_eye_residual(const qScalar* x, const qScalar* x_conj, const qScalar* a, const qScalar* b_conj, qScalar* r6) noexcept {
+    qScalar error[8];
+    dualquat_mul(x_conj, a, error);
+    dualquat_mul(error, x, error);
+    dualquat_mul(error, b_conj, error);
+    if (error[0] < 0) {
+        for (int i=0; i<8; ++i) error[i] = -error[i];
+    }
+    dualquat_tangent(error, r6);
+}
+
+}  // namespace kernel
+
+// hand_eye, X such that A_i X = X B_i for relative motions A_i and B_i
+template<QuatScalar cScalar=double, typename Scalar>
+inline HandEyeResult<cScalar> hand_eye(const DualQuatBatch<Scalar>& a, const DualQuatBatch<Scalar>& b,
+                                       const HandEyeOptions<cScalar>& options=HandEyeOptions<cScalar>()) {
+    using Arr8 = std::array<cScalar, 8>;
+    using Mat66 = std::array<cScalar, 36>;
+    using Mat88 = std::array<cScalar, 64>;
+    const std::size_t size = a.size();
+    if (b.size() != size) {
+        throw std::runtime_error("Error: hand_eye() Motion batches differ in size.");
+    }
+    if (size < 2) {
+        throw std::runtime_error("Error: hand_eye() Requires at least 2 motion pairs.");
+    }
+    const std::size_t threads = options.threads;
+    const auto add = [](Mat88 lhs, const Mat88& rhs) {
+        for (int k=0; k<64; ++k) lhs[k] += rhs[k];
+        return lhs;
+    };
+    // M = sum C^T C, C = hamiplus(A) - haminus(B), with B on the hemisphere of A
+    Mat88 normal = parallel_reduce(std::size_t(0), size, Mat88{}, [&](const std::size_t first, const std::size_t last) {
+        Mat88 sum{};
+        for (std::size_t i=first; i<last; ++i) {
+            const DualQuat<cScalar> a_i = a.template get<cScalar>(i);
+            DualQuat<cScalar> b_i = b.template get<cScalar>(i);
+            if (a_i.real().w() * b_i.real().w() < 0) {
+                b_i = -b_i;
+            }
+            const auto plus = a_i.hamiplus();
+            const auto minus = b_i.haminus();
+            cScalar c[64];
+            for (int r=0; r<8; ++r) {
+                for (int k=0; k<8; ++k) c[r*8 + k] = plus[r][k] - minus[r][k];
+            }
+            for (int r=0; r<8; ++r) {
+                for (int j=0; j<8; ++j) {
+                    const cScalar c_rj = c[r*8 + j];
+                    for (int k=j; k<8; ++k) sum[j*8 + k] += c_rj * c[r*8 + k];
+                }
+            }
+        }
+        return sum;
+    }, add, threads, 1024);
+    for (int j=0; j<8; ++j) {
+        for (int k=0; k<j; ++k) normal[j*8 + k] = normal[k*8 + j];
+    }
+    std::array<cScalar, 8> values;
+    Mat88 vectors;
+    linalg::symmetric_eigen<8>(normal, values, vectors);
+    // x = cos(phi) e_1 + sin(phi) e_2 with real . dual = 0, the root of largest real norm is scaled to unit
+    cScalar u1u1 = 0, u1u2 = 0, u2u2 = 0, u1v1 = 0, u1v2_u2v1 = 0, u2v2 = 0;
+    for (int k=0; k<4; ++k) {
+        const cScalar u1 = vectors[k*8], u2 = vectors[k*8 + 1];
+        const cScalar v1 = vectors[(k+4)*8], v2 = vectors[(k+4)*8 + 1];
+        u1u1 += u1 * u1;
+        u1u2 += u1 * u2;
+        u2u2 += u2 * u2;
+        u1v1 += u1 * v1;
+        u1v2_u2v1 += u1 * v2 + u2 * v1;
+        u2v2 += u2 * v2;
+    }
+    const cScalar half_difference = (u1v1 - u2v2) / 2;
+    const cScalar half_cross = u1v2_u2v1 / 2;
+    const cScalar amplitude = std::sqrt(half_difference * half_difference + half_cross * half_cross);
+    const cScalar shift = std::atan2(half_cross, half_difference);
+    const cScalar spread = amplitude == 0 ? 0 : std::acos(std::clamp(-(u1v1 + u2v2) / (2 * amplitude), cScalar(-1), cScalar(1)));
+    cScalar best_phi = 0, best_norm2 = -1;
+    for (const cScalar phi : { (shift + spread) / 2, (shift - spread) / 2 }) {
+        const cScalar c = std::cos(phi), s = std::sin(phi);
+        const cScalar norm2 = c * c * u1u1 + 2 * c * s * u1u2 + s * s * u2u2;
+        if (norm2 > best_norm2) {
+            best_norm2 = norm2;
+            best_phi = phi;
+        }
+    }
+    Arr8 x;
+    for (int k=0; k<8; ++k) x[k] = std::cos(best_phi) * vectors[k*8] + std::sin(best_phi) * vectors[k*8 + 1];
+    if (x[0] < 0) {
+        for (int k=0; k<8; ++k) x[k] = -x[k];
+    }
+    kernel::dualquat_renormalize(x.data());
+
+    // 0.5 sum |r_i|^2 and, on request, the Gauss-Newton system of right updates x exp(delta)
+    std::vector<Arr8> motions(2 * size);
+    parallel_for(0, size, [&](const std::size_t first, const std::size_t last, std::size_t) {
+        for (std::size_t i=first; i<last; ++i) {
+            cScalar b_i[8];
+            a.load(i, motions[2*i].data());
+            b.load(i, b_i);
+            kernel::dualquat_conj(b_i, motions[2*i + 1].data());
+        }
+    }, threads, 1024);
+    const auto total_error = [&](const Arr8& pose) {
+        Arr8 pose_conj;
+        kernel::dualquat_conj(pose.data(), pose_conj.data());
+        return parallel_reduce(std::size_t(0), size, cScalar(0), [&](const std::size_t first, const std::size_t last) {
+            cScalar sum = 0;
+            cScalar r6[6];
+            for (std::size_t i=first; i<last; ++i) {
+                kernel::hand_eye_residual(pose.data(), pose_conj.data(), motions[2*i].data(), motions[2*i + 1].data(), r6);
+                for (int k=0; k<6; ++k) sum += r6[k] * r6[k];
+            }
+            return sum;
+        }, [](const cScalar lhs, const cScalar rhs) { return lhs + rhs; }, threads, 1024) / 2;
+    };
+    HandEyeResult<cScalar> res;
+    cScalar current_error = total_error(x);
+    res.linear_error = current_error;
+    if (options.refine) {
+        const cScalar step = std::sqrt(std::sqrt(std::numeric_limits<cScalar>::epsilon())) * cScalar(0.1);
+        using Normal = std::array<cScalar, 42>;
+        while (res.iterations < options.max_iterations && current_error > 0) {
+            ++res.iterations;
+            // perturbed poses and their conjugates, shared by every pair
+            std::array<Arr8, 13> perturbed;
+            std::array<Arr8, 13> perturbed_conj;
+            perturbed[0] = x;
+            for (int k=0; k<6; ++k) {
+                cScalar delta[6] = { 0, 0, 0, 0, 0, 0 }, update[8];
+                delta[k] = step;
+                kernel::dualquat_from_tangent(delta, update);
+                kernel::dualquat_mul(x.data(), update, perturbed[1 + 2*k].data());
+                delta[k] = -step;
+                kernel::dualquat_from_tangent(delta, update);
+                kernel::dualquat_mul(x.data(), update, perturbed[2 + 2*k].data());
+            }
+            for (int k=0; k<13; ++k) kernel::dualquat_conj(perturbed[k].data(), perturbed_conj[k].data());
+            // J^T J in the first 36 entries, J^T r in the last 6
+            const Normal normal_equations = parallel_reduce(std::size_t(0), size, Normal{}, [&](const std::size_t first, const std::size_t last) {
+                Normal sum{};
+                Mat66 jacobian;
+                cScalar r6[6], plus[6], minus[6];
+                for (std::size_t i=first; i<last; ++i) {
+                    const cScalar* a_i = motions[2*i].data();
+                    const cScalar* b_conj_i = motions[2*i + 1].data();
+                    kernel::hand_eye_residual(perturbed[0].data(), perturbed_conj[0].data(), a_i, b_conj_i, r6);
+                    for (int k=0; k<6; ++k) {
+                        kernel::hand_eye_residual(perturbed[1 + 2*k].data(), perturbed_conj[1 + 2*k].data(), a_i, b_conj_i, plus);
+                        kernel::hand_eye_residual(perturbed[2 + 2*k].data(), perturbed_conj[2 + 2*k].data(), a_i, b_conj_i, minus);
+                        for (int j=0; j<6; ++j) jacobian[j*6 + k] = (plus[j] - minus[j]) / (2 * step);
+                    }
+                    for (int j=0; j<6; ++j) {
+                        for (int k=0; k<6; ++k) {
+                            cScalar jtj = 0;
+                            for (int l=0; l<6; ++l) jtj += jacobian[l*6 + j] * jacobian[l*6 + k];
+                            sum[j*6 + k] += jtj;
+                        }
+                        cScalar jtr = 0;
+                        for (int l=0; l<6; ++l) jtr += jacobian[l*6 + j] * r6[l];
+                        sum[36 + j] += jtr;
+                    }
+                }
+                return sum;
+            }, [](Normal lhs, const Normal& rhs) {
+                for (int k=0; k<42; ++k) lhs[k] += rhs[k];
+                return lhs;
+            }, threads, 1024);
+            Mat66 jtj;
+            std::copy(normal_equations.begin(), normal_equations.begin() + 36, jtj.begin());
+            cScalar delta[6];
+            for (int k=0; k<6; ++k) delta[k] = -normal_equations[36 + k];
+            if (!linalg::cholesky<6>(jtj)) {
+                break;
+            }
+            linalg::cholesky_solve<6>(jtj, delta);
+            // halve the step until the error decreases
+            bool improved = false, converged = false;
+            for (int halving=0; halving<8; ++halving) {
+                cScalar update[8];
+                Arr8 candidate;
+                kernel::dualquat_from_tangent(delta, update);
+                kernel::dualquat_mul(x.data(), update, candidate.data());
+                const cScalar candidate_error = total_error(candidate);
+                if (candidate_error < current_error) {
+                    converged = current_error - candidate_error < options.tolerance * current_error;
+                    improved = true;
+                    x = candidate;
+                    current_error = candidate_error;
+                    break;
+                }
+                for (int k=0; k<6; ++k) delta[k] /= 2;
+            }
+            if (!improved || converged) {
+                break;
+            }
+        }
+        kernel::dualquat_renormalize(x.data());
+    }
+    res.final_error = current_error;
+    res.pose = Pose<cScalar>(DualQuat<cScalar>(x));
+    return res;
+}
+// hand_eye, X such that A_i X = X B_i for relative motions A_i and B_i
+template<QuatScalar cScalar=double, typename Scalar>
+inline HandEyeResult<cScalar> hand_eye(const std::vector<Pose<Scalar>>& a, const std::vector<Pose<Scalar>>& b,
+                                       const HandEyeOptions<cScalar>& options=HandEyeOptions<cScalar>()) {
+    DualQuatBatch<Scalar> a_batch, b_batch;
+    a_batch.reserve(a.size());
+    b_batch.reserve(b.size());
+    for (const auto& pose : a) a_batch.push_back(pose);
+    for (const auto& pose : b) b_batch.push_back(pose);
+    return hand_eye<cScalar>(a_batch, b_batch, options);
+}
+
+}  // namespace dqpose
@@ -0,0 +1,215 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/chain.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining composition of pose sequences
+ *
+ *     This file provides the routines composing long sequences of poses
+ *     held in a DualQuatBatch. The storage scalar type of the batch and
+ *     the compute scalar type of the running product are independent,
+ *     e.g. poses kept as float are chained in double, and the running
+ *     product is renormalized according to a RenormPolicy.
+ *
+ *     Composition is associative, so parallel_compose splits the sequence
+ *     into per-thread products combined in order, and parallel_accumulate
+ *     runs a blocked scan: every block of threads * block_size poses is
+ *     first reduced per thread, the thread prefixes are chained, then each
+ *     thread rescans its part from its prefix while the block is still in
+ *     cache. Each pose is composed twice, so the scan pays off from two
+ *     threads on.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include "trace_macros.hpp"
+#include <array>
+#include <vector>
+#include <barrier>
+#include <limits>
+#include <algorithm>
+
+namespace dqpose
+{
+
+template<typename qScalar>
+class RenormPolicy {
+public:
+    // compositions between two drift checks, 0 never checks
+    std::size_t period;
+    // accepted squared unit error, see kernel::dualquat_unit_error
+    qScalar tolerance;
+
+    // Default Constructor
+    constexpr explicit RenormPolicy(const std::size_t period_=64,
+                                    const qScalar tolerance_=64*std::numeric_limits<qScalar>::epsilon()) noexcept
+        : period( period_ ), tolerance( tolerance_ ) {
+
+    }
+    // apply, renormalizes dq when the step is due and the drift is above tolerance
+    constexpr inline bool apply(qScalar* dq, const std::size_t step) const {
+        if (period == 0 || step % period != 0) {
+            return false;
+        }
+        if (kernel::dualquat_unit_error(dq) <= tolerance) {
+            return false;
+        }
+        kernel::dualquat_renormalize(dq);
+        return true;
+    }
+};
+
+// compose, the product batch[0] * batch[1] * ... accumulated in cScalar
+template<typename cScalar=double, typename sScalar>
+inline Pose<cScalar> compose(const DualQuatBatch<sScalar>& batch, const RenormPolicy<cScalar>& policy=RenormPolicy<cScalar>()) {
+    DQPOSE_TRACE_SCOPE("dqpose::compose");
+    cScalar result[8] = { 1, 0, 0, 0, 0, 0, 0, 0 };
+    cScalar current[8];
+    for (std::size_t i=0; i<batch.size(); ++i) {
+        batch.load(i, current);
+        kernel::dualquat_mul(result, current, result);
+        policy.apply(result, i + 1);
+    }
+    kernel::dualquat_renormalize(result);
+    return Pose<cScalar>(DualQuat<cScalar>(std::array<cScalar, 8>{ result[0], result[1], result[2], result[3],
+                                                                   result[4], result[5], result[6], result[7] }));
+}
+
+// accumulate, absolute[i] = origin * relative[0] * ... * relative[i], accumulated in cScalar
+template<typename cScalar=double, typename sScalar, typename oScalar>
+inline void accumulate(const DualQuatBatch<sScalar>& relative, DualQuatBatch<oScalar>& absolute,
+                       const Pose<cScalar>& origin=Pose<cScalar>(), const RenormPolicy<cScalar>& policy=RenormPolicy<cScalar>()) {
+    DQPOSE_TRACE_SCOPE("dqpose::accumulate");
+    absolute.resize(relative.size());
+    const Quat<cScalar> origin_real = origin.real();
+    const Quat<cScalar> origin_dual = origin.dual();
+    cScalar result[8];
+    cScalar current[8];
+    std::copy(origin_real.data(), origin_real.data() + 4, result);
+    std::copy(origin_dual.data(), origin_dual.data() + 4, result + 4);
+    for (std::size_t i=0; i<relative.size(); ++i) {
+        relative.load(i, current);
+        kernel::dualquat_mul(result, current, result);
+        policy.apply(result, i + 1);
+        absolute.store(i, result);
+    }
+}
+
+// parallel_compose, compose split over threads, the chunk products combined in order
+template<typename cScalar=double, typename sScalar>
+inline Pose<cScalar> parallel_compose(const DualQuatBatch<sScalar>& batch, const RenormPolicy<cScalar>& policy=RenormPolicy<cScalar>(),
+                                      const std::size_t threads=0, const std::size_t min_chunk=16384) {
+    DQPOSE_TRACE_SCOPE("dqpose::parallel_compose");
+    using Arr8 = std::array<cScalar, 8>;
+    const Arr8 identity = { 1, 0, 0, 0, 0, 0, 0, 0 };
+    Arr8 result = parallel_reduce(std::size_t(0), batch.size(), identity, [&](const std::size_t first, const std::size_t last) {
+        Arr8 product = identity;
+        cScalar current[8];
+        for (std::size_t i=first; i<last; ++i) {
+            batch.load(i, current);
+            kernel::dualquat_mul(product.data(), current, product.data());
+            policy.apply(product.data(), i - first + 1);
+        }
+        return product;
+    }, [](Arr8 lhs, const Arr8& rhs) {
+        kernel::dualquat_mul(lhs.data(), rhs.data(), lhs.data());
+        return lhs;
+    }, threads, min_chunk);
+    kernel::dualquat_renormalize(result.data());
+    return Pose<cScalar>(DualQuat<cScalar>(result));
+}
+
+// parallel_accumulate, accumulate as a blocked parallel scan over blocks of threads * block_size poses
+template<typename cScalar=double, typename sScalar, typename oScalar>
+inline void parallel_accumulate(const DualQuatBatch<sScalar>& relative, DualQuatBatch<oScalar>& absolute,
+                                const Pose<cScalar>& origin=Pose<cScalar>(), const RenormPolicy<cScalar>& policy=RenormPolicy<cScalar>(),
+                                const std::size_t threads=0, const std::size_t block_size=16384) {
+    DQPOSE_TRACE_SCOPE("dqpose::parallel_accumulate");
+    using Arr8 = std::array<cScalar, 8>;
+    const std::size_t size = relative.size();
+    const std::size_t workers = parallel_chunks(0, size, threads, block_size);
+    if (workers == 1) {
+        accumulate(relative, absolute, origin, policy);
+        return;
+    }
+    absolute.resize(size);
+    const Arr8 identity = { 1, 0, 0, 0, 0, 0, 0, 0 };
+    const Arr8 start = origin.array();
+    const std::size_t block = workers * block_size;
+    // thread products of the even and odd blocks, so a block's products stay readable while the next block is reduced
+    std::vector<Arr8> products(2 * workers);
+    std::barrier sync(static_cast<std::ptrdiff_t>(workers));
+    parallel_for(0, workers, [&](std::size_t, std::size_t, const std::size_t worker) {
+        try {
+            Arr8 carry = start;
+            cScalar current[8];
+            for (std::size_t b=0, block_first=0; block_first<size; ++b, block_first+=block) {
+                const std::size_t count = std::min(size - block_first, block);
+                const std::size_t first = block_first + count * worker / workers;
+                const std::size_t last = block_first + count * (worker + 1) / workers;
+                Arr8* block_products = products.data() + (b % 2) * workers;
+                // reduce
+                Arr8 product = identity;
+                for (std::size_t i=first; i<last; ++i) {
+                    relative.load(i, current);
+                    kernel::dualquat_mul(product.data(), current, product.data());
+                    policy.apply(product.data(), i - first + 1);
+                }
+                block_products[worker] = product;
+                sync.arrive_and_wait();
+                // prefix of this thread and carry into the next block, every thread computes the same carry
+                Arr8 prefix = carry;
+                for (std::size_t k=0; k<workers; ++k) {
+                    if (k == worker) prefix = carry;
+                    kernel::dualquat_mul(carry.data(), block_products[k].data(), carry.data());
+                }
+                kernel::dualquat_renormalize(carry.data());
+                // scan
+                for (std::size_t i=first; i<last; ++i) {
+                    relative.load(i, current);
+                    kernel::dualquat_mul(prefix.data(), current, prefix.data());
+                    policy.apply(prefix.data(), i - first + 1);
+                    absolute.store(i, prefix.data());
+                }
+            }
+        } catch (...) {
+            // leave the barrier so the other threads finish, parallel_for rethrows
+            sync.arrive_and_drop();
+            throw;
+        }
+    }, workers, 1);
+}
+
+#ifdef DQPOSE_USE_LIBRARY
+// instantiated once in the dqpose library, see src/dqpose.cpp
+extern template class RenormPolicy<double>;
+extern template Pose<double> compose<double, float>(const DualQuatBatch<float>&, const RenormPolicy<double>&);
+extern template Pose<double> compose<double, double>(const DualQuatBatch<double>&, const RenormPolicy<double>&);
+extern template void accumulate<double, float, float>(const DualQuatBatch<float>&, DualQuatBatch<float>&, const Pose<double>&, const RenormPolicy<double>&);
+extern template void accumulate<double, double, double>(const DualQuatBatch<double>&, DualQuatBatch<double>&, const Pose<double>&, const RenormPolicy<double>&);
+#endif
+
+}  // namespace dqpose
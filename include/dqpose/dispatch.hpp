@@ -0,0 +1,83 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/dispatch.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file declaring the runtime dispatched batch kernels
+ *
+ *     This file declares batch kernels whose code is selected at run time
+ *     for the instruction set of the CPU: the element-wise product, the
+ *     point transform, the normalizations and the screw log and exp of
+ *     float and double batches. Every instruction set has its own
+ *     translation unit in the dqpose library, src/dispatch_*.cpp, and
+ *     fills a table of function pointers. The best table the CPU supports
+ *     is picked on first use, active_isa reports it and force_isa
+ *     overrides it, e.g. to compare variants or pin a fleet to one.
+ *
+ *     Unlike the other headers these kernels are compiled into the dqpose
+ *     library, link the dqpose target to use them.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "dualquat.hpp"
+#include "batch.hpp"
+
+namespace dqpose
+{
+
+// Isa, instruction set variants of the dispatched kernels
+enum class Isa { Generic, AVX2, AVX512 };
+
+// isa_name
+const char* isa_name(const Isa isa) noexcept;
+// isa_supported, whether the CPU runs the variant
+bool isa_supported(const Isa isa) noexcept;
+// active_isa, the variant in use, the best supported one unless forced
+Isa active_isa() noexcept;
+// force_isa, selects the variant for every later call, throws when the CPU does not support it
+void force_isa(const Isa isa);
+
+namespace dispatch
+{
+
+// multiply, out[i] = a[i] b[i], out is resized and may be a or b
+void multiply(const DualQuatBatch<float>& a, const DualQuatBatch<float>& b, DualQuatBatch<float>& out);
+void multiply(const DualQuatBatch<double>& a, const DualQuatBatch<double>& b, DualQuatBatch<double>& out);
+// transform, maps every point through the unit Dual Quaternion pose, p' = r p r* + t
+void transform(const DualQuat<float>& pose, PureQuatBatch<float>& points);
+void transform(const DualQuat<double>& pose, PureQuatBatch<double>& points);
+// normalize, see dqpose::normalize, NormalizeMethod::Fast uses the rsqrt instructions of the variant refined by Newton-Raphson
+void normalize(QuatBatch<float>& batch, const NormalizeMethod method=NormalizeMethod::Exact);
+void normalize(QuatBatch<double>& batch, const NormalizeMethod method=NormalizeMethod::Exact);
+void normalize(DualQuatBatch<float>& batch, const NormalizeMethod method=NormalizeMethod::Exact);
+void normalize(DualQuatBatch<double>& batch, const NormalizeMethod method=NormalizeMethod::Exact);
+// screw_log, see dqpose::screw_log
+void screw_log(const DualQuatBatch<float>& poses, PureQuatBatch<float>& real, PureQuatBatch<float>& dual);
+void screw_log(const DualQuatBatch<double>& poses, PureQuatBatch<double>& real, PureQuatBatch<double>& dual);
+// screw_exp, see dqpose::screw_exp
+void screw_exp(const PureQuatBatch<float>& real, const PureQuatBatch<float>& dual, DualQuatBatch<float>& poses);
+void screw_exp(const PureQuatBatch<double>& real, const PureQuatBatch<double>& dual, DualQuatBatch<double>& poses);
+
+}  // namespace dispatch
+
+}  // namespace dqpose
@@ -31,21 +31,24 @@
 
 #pragma once
 #include "quat.hpp"
+#include "trace_macros.hpp"
+#include <limits>
+#include <type_traits>
 
 namespace dqpose 
 {
 
 // Forward declarations
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class DualQuat;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class PureDualQuat;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class UnitDualQuat;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class UnitPureDualQuat;
    
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class DualQuat{
 public:
 using Arr4 = std::array<qScalar, 4>;
@@ -56,6 +59,53 @@ protected:
     std::array<Quat<qScalar>, 2> _data;
     constexpr inline Quat<qScalar>& _real() {return _data[0];}
     constexpr inline Quat<qScalar>& _dual() {return _data[1];}
+    constexpr inline qScalar* _real_data() noexcept {return _data[0]._data.data();}
+    constexpr inline qScalar* _dual_data() noexcept {return _data[1]._data.data();}
+    constexpr inline const qScalar* _real_data() const noexcept {return _data[0]._data.data();}
+    constexpr inline const qScalar* _dual_data() const noexcept {return _data[1]._data.data();}
+    template<QuatScalar Scalar> friend class DualQuat;
+    // _screw_log, out = the screw logarithm of the unit Dual Quaternion dq, see kernel::unit_dualquat_log
+    static constexpr inline void _screw_log(const DualQuat& dq, DualQuat& out) noexcept {
+        qScalar arr8[8], v6[6];
+        for (int i=0; i<4; ++i) {
+            arr8[i] = dq._real_data()[i];
+            arr8[i+4] = dq._dual_data()[i];
+        }
+        kernel::unit_dualquat_log(arr8, v6);
+        out._real_data()[0] = 0;
+        out._dual_data()[0] = 0;
+        for (int i=0; i<3; ++i) {
+            out._real_data()[i+1] = v6[i];
+            out._dual_data()[i+1] = v6[i+3];
+        }
+    }
+    // _screw_exp, out = the screw exponential of the pure Dual Quaternion dq, see kernel::pure_dualquat_exp
+    static constexpr inline void _screw_exp(const DualQuat& dq, DualQuat& out) noexcept {
+        const qScalar v6[6] = { dq._real_data()[1], dq._real_data()[2], dq._real_data()[3],
+                                dq._dual_data()[1], dq._dual_data()[2], dq._dual_data()[3] };
+        qScalar arr8[8];
+        kernel::pure_dualquat_exp(v6, arr8);
+        for (int i=0; i<4; ++i) {
+            out._real_data()[i] = arr8[i];
+            out._dual_data()[i] = arr8[i+4];
+        }
+    }
+    // _real_inv, the inverse of the real part as 4 scalars
+    constexpr inline void _real_inv(qScalar* out4) const noexcept {
+        const qScalar* r = _real_data();
+        const qScalar norm2 = square(r[0]) + square(r[1]) + square(r[2]) + square(r[3]);
+        out4[0] = r[0] / norm2;
+        out4[1] = - r[1] / norm2;
+        out4[2] = - r[2] / norm2;
+        out4[3] = - r[3] / norm2;
+    }
+    // _assign, copies the scalars only
+    constexpr inline void _assign(const DualQuat& other) noexcept {
+        _data[0]._data = other._data[0]._data;
+        _data[1]._data = other._data[1]._data;
+    }
+    template<typename Scalar1, typename Scalar2, typename Scalar3>
+    friend constexpr void compose_into(DualQuat<Scalar1>& out, const DualQuat<Scalar2>& a, const DualQuat<Scalar3>& b) noexcept;
 public:
     // Default Constructor
     constexpr explicit DualQuat() noexcept
@@ -115,8 +165,7 @@ public:
     // operator*= 
     template<typename Scalar>
     constexpr inline DualQuat& operator*=(const DualQuat<Scalar>& other) noexcept {
-        _dual() = real() * other.dual() + dual() * other.real();
-        _real() *= other.real();
+        compose_into(*this, *this, other);
         return *this;
     }
     // operator*= 
@@ -127,18 +176,50 @@ public:
     }
     // normalize
     constexpr inline DualQuat& normalize() {
-        const qScalar norm = real().norm();
+        const qScalar norm = _data[0].norm();
         if (norm == 0) {
             throw std::runtime_error("Error: DualQuat& normalize() Cannot normalize a 0 Dual Quaternion.");
         }
-        _real() *= ( 1 / norm );
-        _dual() *= ( 1 / norm );
+        const qScalar inv_norm = 1 / norm;
+        _real() *= inv_norm;
+        _dual() *= inv_norm;
         return *this;
     }
     // purifiy
     constexpr inline DualQuat& purify() noexcept {
-        real().purify();
-        dual().purify();
+        _real().purify();
+        _dual().purify();
+        return *this;
+    }
+    // conj_inplace
+    constexpr inline DualQuat& conj_inplace() noexcept {
+        _real().conj_inplace();
+        _dual().conj_inplace();
+        return *this;
+    }
+    // inv_inplace, real^-1 + ϵ ( - real^-1 dual real^-1 )
+    constexpr inline DualQuat& inv_inplace() noexcept {
+        _real().inv_inplace();
+        kernel::quat_mul(_real_data(), _dual_data(), _dual_data());
+        kernel::quat_mul(_dual_data(), _real_data(), _dual_data());
+        _dual() *= qScalar(-1);
+        return *this;
+    }
+    // log_inplace, log(real) + ϵ ( real^-1 dual )
+    constexpr inline DualQuat& log_inplace() noexcept {
+        qScalar real_inv[4];
+        _real_inv(real_inv);
+        kernel::quat_mul(real_inv, _dual_data(), _dual_data());
+        _real().log_inplace();
+        return *this;
+    }
+    // exp_inplace, exp(real) + ϵ ( exp(real) real^-1 dual )
+    constexpr inline DualQuat& exp_inplace() noexcept {
+        qScalar real_inv[4];
+        _real_inv(real_inv);
+        kernel::quat_mul(real_inv, _dual_data(), _dual_data());
+        _real().exp_inplace();
+        kernel::quat_mul(_real_data(), _dual_data(), _dual_data());
         return *this;
     }
     // operator+    
@@ -154,9 +235,9 @@ public:
     // operator*  
     template<typename Scalar>
     constexpr inline DualQuat operator*(const DualQuat<Scalar>& other) const noexcept {
-        const Quat<qScalar>& result_dual = real() * other.dual() + dual() * other.real();
-        const Quat<qScalar>& result_real = real() * other.real();
-        return DualQuat( result_real, result_dual );
+        DualQuat res;
+        compose_into(res, *this, other);
+        return res;
     }
     // operator*  
     template<typename Scalar>
@@ -181,11 +262,39 @@ public:
     }
     // norm
     constexpr inline DualQuat norm() const noexcept {
-        const qScalar result_realnorm = real().norm();
+        const qScalar result_realnorm = norm_real();
         if (result_realnorm == 0) 
             return DualQuat(0);
-        const qScalar res_result_dualnorm = real().dot(dual()) / result_realnorm;
-        return DualQuat(Quat<qScalar>(result_realnorm), Quat<qScalar>(res_result_dualnorm));
+        return DualQuat(result_realnorm, 0, 0, 0, _data[0].dot(_data[1]) / result_realnorm);
+    }
+    // norm_real, the real part of norm(), |real|
+    constexpr inline qScalar norm_real() const noexcept {
+        return _data[0].norm();
+    }
+    // norm_dual, the dual part of norm(), real . dual / |real|
+    constexpr inline qScalar norm_dual() const noexcept {
+        const qScalar result_realnorm = norm_real();
+        return result_realnorm == 0 ? qScalar(0) : _data[0].dot(_data[1]) / result_realnorm;
+    }
+    // unit_error, squared deviation from the unit constraints, (|real|^2 - 1)^2 + (real . dual)^2, no sqrt
+    constexpr inline qScalar unit_error() const noexcept {
+        const qScalar* r = _real_data();
+        const qScalar* d = _dual_data();
+        const qScalar real_norm2 = r[0]*r[0] + r[1]*r[1] + r[2]*r[2] + r[3]*r[3];
+        const qScalar real_dot_dual = r[0]*d[0] + r[1]*d[1] + r[2]*d[2] + r[3]*d[3];
+        return (real_norm2 - 1) * (real_norm2 - 1) + real_dot_dual * real_dot_dual;
+    }
+    // is_unit, unit_error() within tolerance, false for NaN; computed in float for the storage types, as unit_mask
+    template<typename cScalar=std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>>
+    constexpr inline bool is_unit(const cScalar tolerance=64*std::numeric_limits<cScalar>::epsilon()) const noexcept {
+        cScalar r[4], d[4];
+        for (int i=0; i<4; ++i) {
+            r[i] = static_cast<cScalar>(_real_data()[i]);
+            d[i] = static_cast<cScalar>(_dual_data()[i]);
+        }
+        const cScalar real_norm2 = r[0]*r[0] + r[1]*r[1] + r[2]*r[2] + r[3]*r[3];
+        const cScalar real_dot_dual = r[0]*d[0] + r[1]*d[1] + r[2]*d[2] + r[3]*d[3];
+        return (real_norm2 - 1) * (real_norm2 - 1) + real_dot_dual * real_dot_dual <= tolerance;
     }
     // copied
     constexpr inline DualQuat copied() const noexcept {
@@ -193,38 +302,64 @@ public:
     }
     // normalized
     constexpr inline DualQuat normalized() const {
-        const qScalar norm = real().norm();
+        const qScalar norm = _data[0].norm();
         if (norm == 0) {
             throw std::runtime_error("Error: DualQuat normalized() Cannot normalize a 0 Dual Quaternion.");
         }
-        return *this * ( 1 / real().norm() );
+        return *this * ( 1 / norm );
     }
     // purified
     constexpr inline DualQuat purified() const noexcept {
-        return copied().purify();
+        const qScalar* r = _real_data();
+        const qScalar* d = _dual_data();
+        return DualQuat(0, r[1], r[2], r[3], 0, d[1], d[2], d[3]);
     }
     // conj
     constexpr inline DualQuat conj() const noexcept {
-        return DualQuat(real().conj(), dual().conj());
+        DualQuat res;
+        conj_to(res);
+        return res;
     }
     // inv
     constexpr inline DualQuat inv() const noexcept {
-        const Quat<qScalar>& result_real = real().inv();
-        const Quat<qScalar>& result_dual = - result_real * dual() * result_real;
-        return DualQuat( result_real, result_dual );
+        DualQuat res;
+        inv_to(res);
+        return res;
     }
     // log
     constexpr inline DualQuat log() const noexcept {
-        const Quat<qScalar>& result_real = real().log();
-        const Quat<qScalar>& result_dual = real().inv() * dual();
-        return DualQuat( result_real, result_dual );
+        DualQuat res;
+        log_to(res);
+        return res;
     }
     // exp
     constexpr inline DualQuat exp() const noexcept {
-        const Quat<qScalar>& result_real = real().exp();
-        const Quat<qScalar>& result_dual = result_real * real().inv() * dual();
-        return DualQuat( result_real, result_dual );
+        DualQuat res;
+        exp_to(res);
+        return res;
+    }
+    // conj_to, inv_to, log_to, exp_to, write the result into out, which may be *this
+    constexpr inline void conj_to(DualQuat& out) const noexcept {
+        out._assign(*this);
+        out.conj_inplace();
+    }
+    constexpr inline void inv_to(DualQuat& out) const noexcept {
+        out._assign(*this);
+        out.inv_inplace();
+    }
+    constexpr inline void log_to(DualQuat& out) const noexcept {
+        out._assign(*this);
+        out.log_inplace();
+    }
+    constexpr inline void exp_to(DualQuat& out) const noexcept {
+        out._assign(*this);
+        out.exp_inplace();
     }
+    // log_to, exp_to, their results are general Dual Quaternions, out of a derived type would lose its invariant
+    template<typename Out>
+    constexpr inline void log_to(Out& out) const noexcept =delete;
+    template<typename Out>
+    constexpr inline void exp_to(Out& out) const noexcept =delete;
     // pow
     constexpr inline DualQuat pow(const qScalar index) const noexcept {
         return (this->log() * index).exp();
@@ -269,14 +404,13 @@ public:
     constexpr inline const qScalar* data() const noexcept { return _data.data()[0].data(); }
     constexpr inline Arr8 array() const noexcept { 
         Arr8 res;
-        std::copy(data(), data()+8, res.begin());
+        std::copy(_data[0].data(), _data[0].data()+4, res.begin());
+        std::copy(_data[1].data(), _data[1].data()+4, res.begin()+4);
         return res; 
     }
     // to_string
     constexpr inline std::string to_string() const {
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(PRINT_PRECISION) <<  real() << " + " << " ϵ ( " << dual() << " )";
-        return oss.str();
+        return _data[0].to_string() + " + " + " ϵ ( " + _data[1].to_string() + " )";
     }
     // Default
             virtual ~DualQuat()=default;
@@ -286,7 +420,7 @@ public:
     DualQuat& operator=(DualQuat&& dq)=default;
 };
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class PureDualQuat: public DualQuat<qScalar>{
 public:
     // Default Constructor
@@ -354,6 +488,12 @@ public:
         this->purify();
         return *this;
     }
+    // exp, the screw exponential, a unit Dual Quaternion, exact for any screw and free of trigonometric calls for small angles
+    constexpr inline UnitDualQuat<qScalar> exp() const noexcept {
+        UnitDualQuat<qScalar> res;
+        DualQuat<qScalar>::_screw_exp(*this, res);
+        return res;
+    }
 
     // Delete 
     template<typename Scalar>
@@ -362,6 +502,8 @@ public:
     constexpr inline DualQuat<qScalar>& operator-=(const DualQuat<Scalar>& other) noexcept =delete;
     template<typename Scalar>
     constexpr inline DualQuat<qScalar>& operator*=(const DualQuat<Scalar>& other) noexcept =delete;
+    constexpr inline DualQuat<qScalar>& log_inplace() noexcept =delete;
+    constexpr inline DualQuat<qScalar>& exp_inplace() noexcept =delete;
     // Default
             virtual ~PureDualQuat()=default;
                     PureDualQuat(const PureDualQuat& dq)=default;
@@ -371,7 +513,7 @@ public:
 };
 
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class UnitDualQuat: public DualQuat<qScalar>{
 public:
     // Default Constructor
@@ -389,6 +531,12 @@ public:
         : DualQuat<qScalar>( w1, x1, y1, z1, w2, x2, y2, z2 ) {
         this->normalize();
     }
+    // Unnormalized Scalar Constructor, the components must already be unit
+    constexpr explicit UnitDualQuat(Unnormalized, const qScalar w1, const qScalar x1, const qScalar y1, const qScalar z1,
+                                    const qScalar w2, const qScalar x2, const qScalar y2, const qScalar z2) noexcept
+        : DualQuat<qScalar>( w1, x1, y1, z1, w2, x2, y2, z2 ) {
+
+    }
     // Real Constructor
     template<typename Scalar>
     constexpr explicit UnitDualQuat(const Quat<Scalar>& real) noexcept
@@ -418,11 +566,27 @@ public:
     // operator*=
     template<typename Scalar>
     constexpr inline UnitDualQuat& operator*=(const UnitDualQuat<Scalar>& other) noexcept {
-        this->_dual() = this->real() * other.dual() + this->dual() * other.real();
-        this->_real() *= other.real();
+        compose_into(*this, *this, other);
         this->normalize();
         return *this;
     } 
+    // log, the screw logarithm of the shorter rotation, a pure Dual Quaternion, PureDualQuat::exp recovers *this up to
+    // its sign, the same pose
+    constexpr inline PureDualQuat<qScalar> log() const noexcept {
+        PureDualQuat<qScalar> res;
+        DualQuat<qScalar>::_screw_log(*this, res);
+        return res;
+    }
+    // pow, the screw motion of the shorter rotation scaled by index
+    DQPOSE_TRACE_CONSTEXPR inline UnitDualQuat pow(const qScalar index) const noexcept {
+        DQPOSE_TRACE_SCOPE("dqpose::UnitDualQuat::pow");
+        DualQuat<qScalar> screw;
+        DualQuat<qScalar>::_screw_log(*this, screw);
+        screw *= index;
+        UnitDualQuat res;
+        DualQuat<qScalar>::_screw_exp(screw, res);
+        return res;
+    }
     // Delete 
     template<typename Scalar>
     constexpr inline DualQuat<qScalar>& operator+=(const DualQuat<Scalar>& other) noexcept =delete;
@@ -431,6 +595,8 @@ public:
     template<typename Scalar>
     constexpr inline DualQuat<qScalar>& operator*=(const DualQuat<Scalar>& other) noexcept =delete;
     constexpr inline DualQuat<qScalar>& operator*=(const qScalar scalar) noexcept =delete;
+    constexpr inline DualQuat<qScalar>& log_inplace() noexcept =delete;
+    constexpr inline DualQuat<qScalar>& exp_inplace() noexcept =delete;
     // Default
             virtual ~UnitDualQuat()=default;
                     UnitDualQuat(const UnitDualQuat& dq)=default;
@@ -440,7 +606,7 @@ public:
 };
 
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class UnitPureDualQuat: public DualQuat<qScalar>{
 public:
     // Default Constructor
@@ -495,6 +661,8 @@ public:
     template<typename Scalar>
     constexpr inline DualQuat<qScalar>& operator*=(const DualQuat<Scalar>& other) noexcept =delete;
     constexpr inline DualQuat<qScalar>& operator*=(const qScalar scalar) noexcept =delete;
+    constexpr inline DualQuat<qScalar>& log_inplace() noexcept =delete;
+    constexpr inline DualQuat<qScalar>& exp_inplace() noexcept =delete;
     // Default
             virtual ~UnitPureDualQuat()=default;
                     UnitPureDualQuat(const UnitPureDualQuat& dq)=default;
@@ -503,21 +671,47 @@ public:
     UnitPureDualQuat& operator=(UnitPureDualQuat&& dq)=default;
 };
 
+#ifndef DQPOSE_NO_IOSTREAM
 // operator<<
 template<typename Scalar>
 inline std::ostream& operator<<(std::ostream& os, const DualQuat<Scalar>& dq) {
     os << dq.to_string();  
     return os;
 }
+#endif
 // operator*
-template<typename Scalar1, typename Scalar2>
-inline std::enable_if_t<std::is_arithmetic_v<Scalar1>, DualQuat<Scalar2>>
+template<QuatScalar Scalar1, typename Scalar2>
+inline DualQuat<Scalar2>
 operator*(const Scalar1 scalar, const DualQuat<Scalar2>& dq) noexcept {return dq * scalar;}
 // operator*
 template<typename Scalar1, typename Scalar2>
 inline DualQuat<Scalar1> operator*(const Quat<Scalar1>& quat, const DualQuat<Scalar2>& dq) noexcept {
     return DualQuat<Scalar1>( quat * dq.real(), quat * dq.dual() );
 }
+// compose_into, out = a b without temporaries, out may alias a or b
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(DualQuat<Scalar1>& out, const DualQuat<Scalar2>& a, const DualQuat<Scalar3>& b) noexcept {
+    Scalar1 real[4], dual[4], cross[4];
+    kernel::quat_mul(a._real_data(), b._real_data(), real);
+    kernel::quat_mul(a._real_data(), b._dual_data(), dual);
+    kernel::quat_mul(a._dual_data(), b._real_data(), cross);
+    for (int i=0; i<4; ++i) {
+        out._real_data()[i] = real[i];
+        out._dual_data()[i] = dual[i] + cross[i];
+    }
+}
+// compose_into, into a unit Dual Quaternion, only of unit Dual Quaternions
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(UnitDualQuat<Scalar1>& out, const UnitDualQuat<Scalar2>& a, const UnitDualQuat<Scalar3>& b) noexcept {
+    compose_into(static_cast<DualQuat<Scalar1>&>(out), a, b);
+}
+// compose_into, the product is no longer pure, or unit unless both factors are
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(UnitDualQuat<Scalar1>& out, const DualQuat<Scalar2>& a, const DualQuat<Scalar3>& b) noexcept =delete;
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(PureDualQuat<Scalar1>& out, const DualQuat<Scalar2>& a, const DualQuat<Scalar3>& b) noexcept =delete;
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(UnitPureDualQuat<Scalar1>& out, const DualQuat<Scalar2>& a, const DualQuat<Scalar3>& b) noexcept =delete;
 
 using DualQuatf = DualQuat<float>;
 using UnitDualQuatf = UnitDualQuat<float>;
@@ -531,4 +725,26 @@ using DualQuatld = DualQuat<long double>;
 using UnitDualQuatld = UnitDualQuat<long double>;
 using PureDualQuatld = PureDualQuat<long double>;
 using UnitPureDualQuatld = UnitPureDualQuat<long double>;
+using DualQuath = DualQuat<Half>;
+using UnitDualQuath = UnitDualQuat<Half>;
+using PureDualQuath = PureDualQuat<Half>;
+using UnitPureDualQuath = UnitPureDualQuat<Half>;
+using DualQuatbf = DualQuat<BFloat16>;
+using UnitDualQuatbf = UnitDualQuat<BFloat16>;
+using PureDualQuatbf = PureDualQuat<BFloat16>;
+using UnitPureDualQuatbf = UnitPureDualQuat<BFloat16>;
+
+#ifdef DQPOSE_USE_LIBRARY
+// instantiated once in the dqpose library, see src/dqpose.cpp
+#define DQPOSE_EXTERN_DUALQUAT(Scalar) \
+    extern template class DualQuat<Scalar>; \
+    extern template class PureDualQuat<Scalar>; \
+    extern template class UnitDualQuat<Scalar>; \
+    extern template class UnitPureDualQuat<Scalar>;
+DQPOSE_EXTERN_DUALQUAT(float)
+DQPOSE_EXTERN_DUALQUAT(double)
+DQPOSE_EXTERN_DUALQUAT(long double)
+#undef DQPOSE_EXTERN_DUALQUAT
+#endif
+
 }
\ No newline at end of file
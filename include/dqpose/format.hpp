@@ -0,0 +1,358 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/format.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining lossless text formatting and parsing
+ *
+ *     This file provides to_chars and from_chars for Quaternions, Dual
+ *     Quaternions and Poses, plain ASCII components separated by a space,
+ *     "w x y z" and "w1 x1 y1 z1 w2 x2 y2 z2", written into and read from
+ *     caller buffers without allocating. Scalars are written by
+ *     std::to_chars in the shortest form that parses back to the same
+ *     value, types that are not built-in through float. Parsing accepts
+ *     spaces, tabs or a comma between components. With <format>, the
+ *     types also get a std::formatter printing the same text.
+ *
+ *     write_csv and read_csv exchange DualQuatBatches, optionally with a
+ *     timestamp column, as CSV files. Both stream the file through a
+ *     large buffer, so they take a few system calls per megabyte.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "quat.hpp"
+#include "dualquat.hpp"
+#include "pose.hpp"
+#include "batch.hpp"
+#include <array>
+#include <vector>
+#include <string>
+#include <charconv>
+#include <system_error>
+#include <type_traits>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <version>
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+
+namespace dqpose
+{
+
+struct CsvOptions {
+    // separator of the columns
+    char delimiter = ',';
+    // the first column holds the timestamps
+    bool timestamps = true;
+    // write_csv starts with a line naming the columns, read_csv skips a first line that is not a record
+    bool header = true;
+};
+
+namespace kernel
+{
+
+// text_scalar_t, the type a scalar is written and parsed as
+template<typename Scalar>
+using text_scalar_t = std::conditional_t<std::is_arithmetic_v<Scalar>, Scalar, float>;
+
+// text_quat_scalar_t, the scalar a Quaternion, Dual Quaternion or Pose stores
+template<typename T>
+using text_quat_scalar_t = std::remove_cvref_t<decltype(*std::declval<const T&>().data())>;
+
+// text_unit_tolerance, of the scaled unit error of parsed components, 8 rounding errors of the stored scalar squared
+template<typename Scalar, typename cScalar>
+constexpr inline cScalar text_unit_tolerance() noexcept {
+    const cScalar eps = static_cast<cScalar>(std::numeric_limits<Scalar>::epsilon());
+    return 64 * eps * eps;
+}
+
+// text_unit_error, squared deviation from |real| = 1 plus that of real . dual = 0 relative to 1 + |dual|, so that the
+// rounding of a large translation does not count against it
+template<typename cScalar>
+constexpr inline cScalar text_unit_error(const cScalar* dq) noexcept {
+    const cScalar real_norm2 = dq[0]*dq[0] + dq[1]*dq[1] + dq[2]*dq[2] + dq[3]*dq[3];
+    const cScalar dual_norm2 = dq[4]*dq[4] + dq[5]*dq[5] + dq[6]*dq[6] + dq[7]*dq[7];
+    const cScalar real_dot_dual = dq[0]*dq[4] + dq[1]*dq[5] + dq[2]*dq[6] + dq[3]*dq[7];
+    return (real_norm2 - 1) * (real_norm2 - 1) + real_dot_dual * real_dot_dual / (1 + dual_norm2);
+}
+
+// text_scalar_chars, an upper bound of the characters of one scalar
+inline constexpr std::size_t text_scalar_chars = 64;
+
+// text_components, 4 for Quaternions and 8 for Dual Quaternions, derived types included
+template<typename Scalar>
+std::integral_constant<std::size_t, 4> text_components(const Quat<Scalar>*);
+template<typename Scalar>
+std::integral_constant<std::size_t, 8> text_components(const DualQuat<Scalar>*);
+
+// format_scalars, writes count scalars separated by the separator, errc::value_too_large when the buffer is too short
+template<typename Scalar>
+inline std::to_chars_result format_scalars(char* first, char* last, const Scalar* values, const std::size_t count,
+                                           const char separator=' ') noexcept {
+    for (std::size_t i=0; i<count; ++i) {
+        if (i != 0) {
+            if (first == last) return { last, std::errc::value_too_large };
+            *first++ = separator;
+        }
+        const std::to_chars_result res = std::to_chars(first, last, static_cast<text_scalar_t<Scalar>>(values[i]));
+        if (res.ec != std::errc()) return res;
+        first = res.ptr;
+    }
+    return { first, std::errc() };
+}
+
+// parse_scalars, reads count scalars separated by spaces, tabs or one delimiter, leading spaces and tabs are skipped,
+// errc::invalid_argument pointing at the first character that is not a scalar
+template<typename Scalar>
+inline std::from_chars_result parse_scalars(const char* first, const char* last, Scalar* values, const std::size_t count,
+                                            const char delimiter=',') noexcept {
+    const auto blank = [](const char c) { return c == ' ' || c == '\t'; };
+    for (std::size_t i=0; i<count; ++i) {
+        while (first != last && blank(*first)) ++first;
+        if (i != 0 && first != last && *first == delimiter) {
+            ++first;
+            while (first != last && blank(*first)) ++first;
+        }
+        text_scalar_t<Scalar> value;
+        const std::from_chars_result res = std::from_chars(first, last, value);
+        if (res.ec != std::errc()) return res;
+        values[i] = static_cast<Scalar>(value);
+        first = res.ptr;
+    }
+    return { first, std::errc() };
+}
+
+}  // namespace kernel
+
+// TextQuat, types written and parsed as their 4 or 8 components
+template<typename T>
+concept TextQuat = requires(const T* quat) { kernel::text_components(quat); };
+
+// to_chars, the components of a Quaternion, Dual Quaternion or Pose separated by the separator, shortest round-trip form
+template<TextQuat T>
+inline std::to_chars_result to_chars(char* first, char* last, const T& quat, const char separator=' ') noexcept {
+    constexpr std::size_t count = decltype(kernel::text_components(static_cast<const T*>(nullptr)))::value;
+    if constexpr (count == 4) {
+        return kernel::format_scalars(first, last, quat.data(), 4, separator);
+    } else {
+        const auto arr8 = quat.array();
+        return kernel::format_scalars(first, last, arr8.data(), 8, separator);
+    }
+}
+
+// from_chars, a Quaternion, Dual Quaternion or Pose written by to_chars; the unit types keep components whose
+// kernel::text_unit_error is within the tolerance as they are, so what to_chars wrote reads back bit exact, and
+// normalize the others; the default tolerance follows the epsilon of the stored scalar; out is left unchanged on errors
+template<TextQuat T, typename cScalar=kernel::text_scalar_t<kernel::text_quat_scalar_t<T>>>
+inline std::from_chars_result from_chars(const char* first, const char* last, T& out,
+                                         const cScalar tolerance=kernel::text_unit_tolerance<kernel::text_quat_scalar_t<T>, cScalar>()) {
+    using Scalar = kernel::text_quat_scalar_t<T>;
+    constexpr std::size_t count = decltype(kernel::text_components(static_cast<const T*>(nullptr)))::value;
+    Scalar values[count];
+    const std::from_chars_result res = kernel::parse_scalars(first, last, values, count);
+    if (res.ec != std::errc()) return res;
+    cScalar unit[8] = { };
+    for (std::size_t k=0; k<count; ++k) unit[k] = static_cast<cScalar>(values[k]);
+    const bool is_unit = kernel::text_unit_error(unit) <= tolerance;
+    if constexpr (count == 4) {
+        if constexpr (std::is_constructible_v<T, Unnormalized, Scalar, Scalar, Scalar, Scalar>) {
+            if (is_unit) {
+                out = T(unnormalized, values[0], values[1], values[2], values[3]);
+                return res;
+            }
+        }
+        out = T(values[0], values[1], values[2], values[3]);
+    } else {
+        if constexpr (std::is_constructible_v<T, Unnormalized, Scalar, Scalar, Scalar, Scalar, Scalar, Scalar, Scalar, Scalar>) {
+            if (is_unit) {
+                out = T(unnormalized, values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+                return res;
+            }
+        }
+        out = T(values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+    }
+    return res;
+}
+
+// to_text, as to_chars into a string
+template<TextQuat T>
+inline std::string to_text(const T& quat, const char separator=' ') {
+    char buffer[8 * (kernel::text_scalar_chars + 1)];
+    const std::to_chars_result res = to_chars(buffer, buffer + sizeof(buffer), quat, separator);
+    return std::string(buffer, res.ptr);
+}
+
+// write_csv, one line per pose, the timestamp first when the options ask for it
+template<typename Scalar>
+inline void write_csv(const std::string& path, const double* timestamps, const DualQuatBatch<Scalar>& poses,
+                      const CsvOptions& options=CsvOptions()) {
+    if (options.timestamps && !timestamps && !poses.empty()) {
+        throw std::runtime_error("Error: write_csv() The options ask for timestamps but none are given.");
+    }
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Error: write_csv() Failed opening " + path + ".");
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    constexpr std::size_t line_chars = 9 * (kernel::text_scalar_chars + 1) + 1;
+    std::vector<char> buffer(std::max<std::size_t>(1 << 20, 2 * line_chars));
+    char* const begin = buffer.data();
+    char* const end = begin + buffer.size();
+    char* out = begin;
+    bool failed = false;
+    const auto drain = [&]() {
+        failed = failed || std::fwrite(begin, 1, static_cast<std::size_t>(out - begin), file) != static_cast<std::size_t>(out - begin);
+        out = begin;
+    };
+    if (options.header) {
+        static constexpr const char* columns[9] = { "timestamp", "w1", "x1", "y1", "z1", "w2", "x2", "y2", "z2" };
+        for (std::size_t c=options.timestamps ? 0 : 1; c<9; ++c) {
+            out = std::copy(columns[c], columns[c] + std::strlen(columns[c]), out);
+            *out++ = c == 8 ? '\n' : options.delimiter;
+        }
+    }
+    for (std::size_t i=0; i<poses.size(); ++i) {
+        if (static_cast<std::size_t>(end - out) < line_chars) drain();
+        if (options.timestamps) {
+            out = std::to_chars(out, end, timestamps[i]).ptr;
+            *out++ = options.delimiter;
+        }
+        Scalar arr8[8];
+        poses.load(i, arr8);
+        out = kernel::format_scalars(out, end, arr8, 8, options.delimiter).ptr;
+        *out++ = '\n';
+    }
+    drain();
+    failed = std::fclose(file) != 0 || failed;
+    if (failed) {
+        throw std::runtime_error("Error: write_csv() Failed writing " + path + ".");
+    }
+}
+
+// write_csv, without timestamps
+template<typename Scalar>
+inline void write_csv(const std::string& path, const DualQuatBatch<Scalar>& poses, CsvOptions options=CsvOptions()) {
+    options.timestamps = false;
+    write_csv(path, nullptr, poses, options);
+}
+
+// read_csv, appends the records of a file written by write_csv or with the same columns, the timestamps only when
+// the options ask for them, returns the number appended; empty lines are skipped and a line ending in "\r\n" is accepted
+template<typename Scalar>
+inline std::size_t read_csv(const std::string& path, std::vector<double>& timestamps, DualQuatBatch<Scalar>& poses,
+                            const CsvOptions& options=CsvOptions()) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Error: read_csv() Failed opening " + path + ".");
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    std::vector<char> buffer(1 << 20);
+    std::size_t filled = 0, line = 0, count = 0;
+    bool end_of_file = false;
+    const auto fail = [&](const std::string& message) {
+        std::fclose(file);
+        throw std::runtime_error("Error: read_csv() " + message);
+    };
+    const auto skip = [&](const char* first, const char* last) {
+        while (first != last && (*first == ' ' || *first == '\t' || *first == '\r' || *first == options.delimiter)) ++first;
+        return first;
+    };
+    while (!end_of_file) {
+        const std::size_t read = std::fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+        if (read < buffer.size() - filled) {
+            if (std::ferror(file)) fail("Failed reading " + path + ".");
+            end_of_file = true;
+        }
+        filled += read;
+        const char* first = buffer.data();
+        const char* const last = buffer.data() + filled;
+        for (;;) {
+            const char* newline = std::find(first, last, '\n');
+            if (newline == last && !end_of_file) break;
+            if (newline == last && first == last) break;
+            ++line;
+            double timestamp = 0;
+            Scalar arr8[8];
+            const char* cursor = skip(first, newline);
+            bool parsed = cursor != newline;
+            if (parsed && options.timestamps) {
+                const std::from_chars_result res = std::from_chars(cursor, newline, timestamp);
+                parsed = res.ec == std::errc();
+                cursor = skip(res.ptr, newline);
+            }
+            if (parsed) {
+                const std::from_chars_result res = kernel::parse_scalars(cursor, newline, arr8, 8, options.delimiter);
+                parsed = res.ec == std::errc() && skip(res.ptr, newline) == newline;
+            }
+            if (parsed) {
+                if (options.timestamps) timestamps.push_back(timestamp);
+                poses.resize(poses.size() + 1);
+                poses.store(poses.size() - 1, arr8);
+                ++count;
+            } else if (skip(first, newline) != newline && !(line == 1 && options.header)) {
+                fail("Malformed record at line " + std::to_string(line) + " of " + path + ".");
+            }
+            first = newline == last ? last : newline + 1;
+        }
+        filled = static_cast<std::size_t>(last - first);
+        if (filled == buffer.size()) buffer.resize(2 * buffer.size());
+        std::memmove(buffer.data(), first, filled);
+    }
+    std::fclose(file);
+    return count;
+}
+
+// read_csv, without timestamps
+template<typename Scalar>
+inline std::size_t read_csv(const std::string& path, DualQuatBatch<Scalar>& poses, CsvOptions options=CsvOptions()) {
+    std::vector<double> timestamps;
+    options.timestamps = false;
+    return read_csv(path, timestamps, poses, options);
+}
+
+}  // namespace dqpose
+
+#if defined(__cpp_lib_format)
+// std::formatter, prints the text of to_chars, "{}" takes no format specification
+template<dqpose::TextQuat T>
+struct std::formatter<T, char> {
+    template<typename ParseContext>
+    constexpr typename ParseContext::iterator parse(ParseContext& ctx) {
+        auto it = ctx.begin();
+        if (it != ctx.end() && *it != '}') {
+            throw std::format_error("Error: std::formatter<dqpose> Takes no format specification.");
+        }
+        return it;
+    }
+    template<typename FormatContext>
+    typename FormatContext::iterator format(const T& quat, FormatContext& ctx) const {
+        char buffer[8 * (dqpose::kernel::text_scalar_chars + 1)];
+        const std::to_chars_result res = dqpose::to_chars(buffer, buffer + sizeof(buffer), quat);
+        return std::copy(buffer, res.ptr, ctx.out());
+    }
+};
+#endif
@@ -0,0 +1,304 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/half.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining 16-bit storage scalar types
+ *
+ *     This file provides Half (IEEE 754 binary16) and BFloat16 (brain
+ *     floating point), two 16-bit storage types. Both hold only the bit
+ *     pattern and perform every arithmetic operation in float, so they
+ *     are meant for storing Quaternions, not for long computations. The
+ *     array conversion kernels use F16C when the target supports it.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include <bit>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace dqpose
+{
+
+class Half {
+protected:
+    std::uint16_t _bits;
+public:
+    // Default Constructor
+    constexpr Half() noexcept
+        : _bits( 0 ) {
+
+    }
+    // Float Constructor, rounds to nearest even
+    constexpr Half(const float value) noexcept
+        : _bits( from_float(value) ) {
+
+    }
+    // operator float
+    constexpr inline operator float() const noexcept { return to_float(_bits); }
+    // compound operators
+    constexpr inline Half& operator+=(const float other) noexcept { return *this = float(*this) + other; }
+    constexpr inline Half& operator-=(const float other) noexcept { return *this = float(*this) - other; }
+    constexpr inline Half& operator*=(const float other) noexcept { return *this = float(*this) * other; }
+    constexpr inline Half& operator/=(const float other) noexcept { return *this = float(*this) / other; }
+    // bits
+    constexpr inline std::uint16_t bits() const noexcept { return _bits; }
+    constexpr static Half from_bits(const std::uint16_t bits) noexcept {
+        Half res;
+        res._bits = bits;
+        return res;
+    }
+    // from_float
+    constexpr static std::uint16_t from_float(const float value) noexcept {
+        const std::uint32_t f = std::bit_cast<std::uint32_t>(value);
+        const std::uint32_t sign = (f >> 16) & 0x8000u;
+        const std::uint32_t abs = f & 0x7fffffffu;
+        // NaN keeps a quiet payload, Inf and overflow saturate to Inf
+        if (abs > 0x7f800000u) {
+            return static_cast<std::uint16_t>(sign | 0x7e00u | ((abs >> 13) & 0x3ffu));
+        }
+        if (abs >= 0x477ff000u) {
+            return static_cast<std::uint16_t>(sign | 0x7c00u);
+        }
+        // normal range
+        if (abs >= 0x38800000u) {
+            const std::uint32_t rounded = abs + 0xfffu + ((abs >> 13) & 1u) - 0x38000000u;
+            return static_cast<std::uint16_t>(sign | (rounded >> 13));
+        }
+        // subnormal range and underflow
+        if (abs < 0x33000000u) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        const std::uint32_t exponent = abs >> 23;
+        const std::uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+        const std::uint32_t shift = 126u - exponent;
+        std::uint32_t res = mantissa >> shift;
+        const std::uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const std::uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (res & 1u))) {
+            ++res;
+        }
+        return static_cast<std::uint16_t>(sign | res);
+    }
+    // to_float
+    constexpr static float to_float(const std::uint16_t bits) noexcept {
+        const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16;
+        const std::uint32_t exponent = (bits >> 10) & 0x1fu;
+        std::uint32_t mantissa = bits & 0x3ffu;
+        if (exponent == 0x1fu) {
+            return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+        }
+        if (exponent != 0) {
+            return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+        }
+        if (mantissa == 0) {
+            return std::bit_cast<float>(sign);
+        }
+        // subnormal, renormalize the mantissa
+        std::uint32_t e = 113u;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            --e;
+        }
+        return std::bit_cast<float>(sign | (e << 23) | ((mantissa & 0x3ffu) << 13));
+    }
+};
+
+class BFloat16 {
+protected:
+    std::uint16_t _bits;
+public:
+    // Default Constructor
+    constexpr BFloat16() noexcept
+        : _bits( 0 ) {
+
+    }
+    // Float Constructor, rounds to nearest even
+    constexpr BFloat16(const float value) noexcept
+        : _bits( from_float(value) ) {
+
+    }
+    // operator float
+    constexpr inline operator float() const noexcept { return to_float(_bits); }
+    // compound operators
+    constexpr inline BFloat16& operator+=(const float other) noexcept { return *this = float(*this) + other; }
+    constexpr inline BFloat16& operator-=(const float other) noexcept { return *this = float(*this) - other; }
+    constexpr inline BFloat16& operator*=(const float other) noexcept { return *this = float(*this) * other; }
+    constexpr inline BFloat16& operator/=(const float other) noexcept { return *this = float(*this) / other; }
+    // bits
+    constexpr inline std::uint16_t bits() const noexcept { return _bits; }
+    constexpr static BFloat16 from_bits(const std::uint16_t bits) noexcept {
+        BFloat16 res;
+        res._bits = bits;
+        return res;
+    }
+    // from_float
+    constexpr static std::uint16_t from_float(const float value) noexcept {
+        const std::uint32_t f = std::bit_cast<std::uint32_t>(value);
+        if ((f & 0x7fffffffu) > 0x7f800000u) {
+            return static_cast<std::uint16_t>((f >> 16) | 0x40u);
+        }
+        return static_cast<std::uint16_t>((f + 0x7fffu + ((f >> 16) & 1u)) >> 16);
+    }
+    // to_float
+    constexpr static float to_float(const std::uint16_t bits) noexcept {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16);
+    }
+};
+
+namespace kernel
+{
+
+// convert, element-wise conversion between scalar arrays
+template<typename dScalar, typename sScalar>
+inline void convert(const sScalar* src, dScalar* dst, const std::size_t size) noexcept {
+    for (std::size_t i=0; i<size; ++i) {
+        dst[i] = static_cast<dScalar>(src[i]);
+    }
+}
+// convert, Half to float
+inline void convert(const Half* src, float* dst, const std::size_t size) noexcept {
+    std::size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= size; i += 8) {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#endif
+    for (; i<size; ++i) {
+        dst[i] = Half::to_float(src[i].bits());
+    }
+}
+// convert, float to Half
+inline void convert(const float* src, Half* dst, const std::size_t size) noexcept {
+    std::size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= size; i += 8) {
+        const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+#endif
+    for (; i<size; ++i) {
+        dst[i] = Half::from_bits(Half::from_float(src[i]));
+    }
+}
+// convert, BFloat16 to float
+inline void convert(const BFloat16* src, float* dst, const std::size_t size) noexcept {
+    for (std::size_t i=0; i<size; ++i) {
+        dst[i] = BFloat16::to_float(src[i].bits());
+    }
+}
+// convert, float to BFloat16
+inline void convert(const float* src, BFloat16* dst, const std::size_t size) noexcept {
+    for (std::size_t i=0; i<size; ++i) {
+        dst[i] = BFloat16::from_bits(BFloat16::from_float(src[i]));
+    }
+}
+
+}  // namespace kernel
+
+}  // namespace dqpose
+
+// numeric_limits, of the 16-bit storage types, the values are exact in float
+namespace std
+{
+
+template<>
+class numeric_limits<dqpose::Half> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr std::float_denorm_style has_denorm = std::denorm_present;
+    static constexpr bool has_denorm_loss = false;
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+    static constexpr bool is_iec559 = true;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = 11;
+    static constexpr int digits10 = 3;
+    static constexpr int max_digits10 = 5;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = -13;
+    static constexpr int min_exponent10 = -4;
+    static constexpr int max_exponent = 16;
+    static constexpr int max_exponent10 = 4;
+    static constexpr bool traps = false;
+    static constexpr bool tinyness_before = false;
+    static constexpr dqpose::Half min() noexcept { return dqpose::Half::from_bits(0x0400u); }
+    static constexpr dqpose::Half lowest() noexcept { return dqpose::Half::from_bits(0xfbffu); }
+    static constexpr dqpose::Half max() noexcept { return dqpose::Half::from_bits(0x7bffu); }
+    static constexpr dqpose::Half epsilon() noexcept { return dqpose::Half::from_bits(0x1400u); }
+    static constexpr dqpose::Half round_error() noexcept { return dqpose::Half::from_bits(0x3800u); }
+    static constexpr dqpose::Half infinity() noexcept { return dqpose::Half::from_bits(0x7c00u); }
+    static constexpr dqpose::Half quiet_NaN() noexcept { return dqpose::Half::from_bits(0x7e00u); }
+    static constexpr dqpose::Half signaling_NaN() noexcept { return dqpose::Half::from_bits(0x7d00u); }
+    static constexpr dqpose::Half denorm_min() noexcept { return dqpose::Half::from_bits(0x0001u); }
+};
+
+template<>
+class numeric_limits<dqpose::BFloat16> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr std::float_denorm_style has_denorm = std::denorm_present;
+    static constexpr bool has_denorm_loss = false;
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+    static constexpr bool is_iec559 = false;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = 8;
+    static constexpr int digits10 = 2;
+    static constexpr int max_digits10 = 4;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = -125;
+    static constexpr int min_exponent10 = -37;
+    static constexpr int max_exponent = 128;
+    static constexpr int max_exponent10 = 38;
+    static constexpr bool traps = false;
+    static constexpr bool tinyness_before = false;
+    static constexpr dqpose::BFloat16 min() noexcept { return dqpose::BFloat16::from_bits(0x0080u); }
+    static constexpr dqpose::BFloat16 lowest() noexcept { return dqpose::BFloat16::from_bits(0xff7fu); }
+    static constexpr dqpose::BFloat16 max() noexcept { return dqpose::BFloat16::from_bits(0x7f7fu); }
+    static constexpr dqpose::BFloat16 epsilon() noexcept { return dqpose::BFloat16::from_bits(0x3c00u); }
+    static constexpr dqpose::BFloat16 round_error() noexcept { return dqpose::BFloat16::from_bits(0x3f00u); }
+    static constexpr dqpose::BFloat16 infinity() noexcept { return dqpose::BFloat16::from_bits(0x7f80u); }
+    static constexpr dqpose::BFloat16 quiet_NaN() noexcept { return dqpose::BFloat16::from_bits(0x7fc0u); }
+    static constexpr dqpose::BFloat16 signaling_NaN() noexcept { return dqpose::BFloat16::from_bits(0x7fa0u); }
+    static constexpr dqpose::BFloat16 denorm_min() noexcept { return dqpose::BFloat16::from_bits(0x0001u); }
+};
+
+}  // namespace std
@@ -0,0 +1,195 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/integrator.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining twist integration on the exponential map
+ *
+ *     This file provides PoseIntegrator and BatchIntegrator, which advance
+ *     Poses by body-frame twists, angular + ϵ linear velocity, held over a
+ *     step dt: pose = pose exp(dt / 2 twist). The exponential is the closed
+ *     form screw motion, exact for a constant twist, and steps small enough
+ *     for its Taylor expansion take no trigonometric call.
+ *
+ *     Poses are kept as raw scalars and are not renormalized every step:
+ *     every renormalize_interval steps the squared drift from the unit
+ *     constraints is checked and a pose is projected back only past the
+ *     tolerance. BatchIntegrator keeps many independent agents in a
+ *     DualQuatBatch and splits them over parallel_for.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include "trace_macros.hpp"
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace dqpose
+{
+
+template<QuatScalar qScalar>
+struct IntegratorOptions {
+    // steps between drift checks, 0 never checks
+    std::size_t renormalize_interval = 64;
+    // squared drift from the unit constraints above which a pose is renormalized
+    qScalar renormalize_tolerance = 64 * std::numeric_limits<qScalar>::epsilon();
+    // threads of BatchIntegrator, 0 uses every hardware thread
+    std::size_t threads = 0;
+};
+
+namespace kernel
+{
+
+// integrate_twist, dq = dq exp(dt / 2 twist) for the body-frame twist given as angular3 and linear3
+template<typename qScalar, typename Scalar>
+inline void integrate_twist(qScalar* dq, const Scalar* angular3, const Scalar* linear3, const qScalar dt) noexcept {
+    const qScalar half_dt = dt / 2;
+    const qScalar v6[6] = { half_dt * static_cast<qScalar>(angular3[0]), half_dt * static_cast<qScalar>(angular3[1]),
+                            half_dt * static_cast<qScalar>(angular3[2]), half_dt * static_cast<qScalar>(linear3[0]),
+                            half_dt * static_cast<qScalar>(linear3[1]), half_dt * static_cast<qScalar>(linear3[2]) };
+    qScalar increment[8];
+    pure_dualquat_exp(v6, increment);
+    dualquat_mul(dq, increment, dq);
+}
+
+}  // namespace kernel
+
+template<QuatScalar qScalar>
+class PoseIntegrator {
+protected:
+    std::array<qScalar, 8> _pose;
+    IntegratorOptions<qScalar> _options;
+    std::size_t _steps;
+public:
+    // Pose Constructor
+    template<typename Scalar=qScalar>
+    explicit PoseIntegrator(const Pose<Scalar>& initial=Pose<Scalar>(), const IntegratorOptions<qScalar>& options=IntegratorOptions<qScalar>())
+        : _pose{ }, _options( options ), _steps( 0 ) {
+        reset(initial);
+    }
+    // reset, restarts from a pose
+    template<typename Scalar>
+    inline void reset(const Pose<Scalar>& pose) noexcept {
+        const Quat<Scalar> real = pose.real();
+        const Quat<Scalar> dual = pose.dual();
+        for (int k=0; k<4; ++k) {
+            _pose[k] = static_cast<qScalar>(real.data()[k]);
+            _pose[k+4] = static_cast<qScalar>(dual.data()[k]);
+        }
+        _steps = 0;
+    }
+    // step, by the angular and linear velocity in the body frame
+    template<typename Scalar>
+    inline void step(const Scalar* angular3, const Scalar* linear3, const qScalar dt) {
+        kernel::integrate_twist(_pose.data(), angular3, linear3, dt);
+        ++_steps;
+        if (_options.renormalize_interval != 0 && _steps % _options.renormalize_interval == 0 &&
+            !(kernel::dualquat_unit_error(_pose.data()) <= _options.renormalize_tolerance)) {
+            kernel::dualquat_renormalize(_pose.data());
+        }
+    }
+    // step, by the body-frame twist angular + ϵ linear
+    template<typename Scalar>
+    inline void step(const PureDualQuat<Scalar>& twist, const qScalar dt) {
+        const Quat<Scalar> angular = twist.real();
+        const Quat<Scalar> linear = twist.dual();
+        step(angular.data() + 1, linear.data() + 1, dt);
+    }
+    // pose
+    inline Pose<qScalar> pose() const noexcept {
+        return Pose<qScalar>(_pose[0], _pose[1], _pose[2], _pose[3], _pose[4], _pose[5], _pose[6], _pose[7]);
+    }
+    // steps, since the last reset
+    inline std::size_t steps() const noexcept { return _steps; }
+};
+
+template<QuatScalar qScalar>
+class BatchIntegrator {
+protected:
+    DualQuatBatch<qScalar> _poses;
+    IntegratorOptions<qScalar> _options;
+    std::size_t _steps;
+public:
+    // Size Constructor, every agent starts at the identity
+    explicit BatchIntegrator(const std::size_t size=0, const IntegratorOptions<qScalar>& options=IntegratorOptions<qScalar>())
+        : _poses( size ), _options( options ), _steps( 0 ) {
+        std::fill(_poses.data(0), _poses.data(0) + size, qScalar(1));
+    }
+    // Batch Constructor
+    template<typename Scalar>
+    explicit BatchIntegrator(const DualQuatBatch<Scalar>& initial, const IntegratorOptions<qScalar>& options=IntegratorOptions<qScalar>())
+        : _poses( ), _options( options ), _steps( 0 ) {
+        convert(initial, _poses);
+    }
+    // size
+    inline std::size_t size() const noexcept { return _poses.size(); }
+    // step, every agent by its own angular and linear velocity in the body frame
+    template<typename Scalar>
+    inline void step(const PureQuatBatch<Scalar>& angular, const PureQuatBatch<Scalar>& linear, const qScalar dt) {
+        DQPOSE_TRACE_SCOPE("dqpose::BatchIntegrator::step");
+        const std::size_t size = _poses.size();
+        if (angular.size() != size || linear.size() != size) {
+            throw std::runtime_error("Error: BatchIntegrator::step() Twist batches differ in size from the agents.");
+        }
+        ++_steps;
+        const bool check = _options.renormalize_interval != 0 && _steps % _options.renormalize_interval == 0;
+        parallel_for(0, size, [&](const std::size_t first, const std::size_t last, std::size_t) {
+            for (std::size_t i=first; i<last; ++i) {
+                qScalar dq[8];
+                Scalar angular3[3], linear3[3];
+                _poses.load(i, dq);
+                angular.load(i, angular3);
+                linear.load(i, linear3);
+                kernel::integrate_twist(dq, angular3, linear3, dt);
+                if (check && !(kernel::dualquat_unit_error(dq) <= _options.renormalize_tolerance)) {
+                    kernel::dualquat_renormalize(dq);
+                }
+                _poses.store(i, dq);
+            }
+        }, _options.threads, 4096);
+    }
+    // poses, raw and possibly drifted by less than the tolerance
+    inline const DualQuatBatch<qScalar>& poses() const noexcept { return _poses; }
+    // pose, of the i-th agent
+    inline Pose<qScalar> pose(const std::size_t i) const {
+        qScalar dq[8];
+        _poses.load(i, dq);
+        return Pose<qScalar>(dq[0], dq[1], dq[2], dq[3], dq[4], dq[5], dq[6], dq[7]);
+    }
+    // steps
+    inline std::size_t steps() const noexcept { return _steps; }
+};
+
+using PoseIntegratorf = PoseIntegrator<float>;
+using PoseIntegratord = PoseIntegrator<double>;
+using PoseIntegratorld = PoseIntegrator<long double>;
+using BatchIntegratorf = BatchIntegrator<float>;
+using BatchIntegratord = BatchIntegrator<double>;
+using BatchIntegratorld = BatchIntegrator<long double>;
+
+}  // namespace dqpose
@@ -0,0 +1,449 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/kernel.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining raw-array Quaternion kernels
+ *
+ *     This file provides the object-free primitives shared by the batch
+ *     containers and the composition routines. Every kernel reads and
+ *     writes plain scalar arrays laid out as the classes store them,
+ *     w x y z for a Quaternion and real then dual for a Dual Quaternion,
+ *     so that storage and compute scalar types can differ.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include <cmath>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+namespace dqpose
+{
+
+// MatrixLayout, storage order of the matrices read and written by the conversion routines
+enum class MatrixLayout { RowMajor, ColMajor };
+// NormalizeMethod, how the batch normalizations compute 1 / |q|: the exact root, kernel::rsqrt, or the first order
+// expansion around |q| = 1 for elements within kernel::near_unit_limit and the exact root for the rest
+enum class NormalizeMethod { Exact, Fast, NearUnit };
+
+namespace kernel
+{
+
+// quat_mul, out may alias a or b
+template<typename qScalar, typename Scalar1, typename Scalar2>
+constexpr inline void quat_mul(const Scalar1* a, const Scalar2* b, qScalar* out) noexcept {
+    const qScalar a_w = static_cast<qScalar>(a[0]);
+    const qScalar a_x = static_cast<qScalar>(a[1]);
+    const qScalar a_y = static_cast<qScalar>(a[2]);
+    const qScalar a_z = static_cast<qScalar>(a[3]);
+    const qScalar b_w = static_cast<qScalar>(b[0]);
+    const qScalar b_x = static_cast<qScalar>(b[1]);
+    const qScalar b_y = static_cast<qScalar>(b[2]);
+    const qScalar b_z = static_cast<qScalar>(b[3]);
+    out[0] = a_w*b_w - a_x*b_x - a_y*b_y - a_z*b_z;
+    out[1] = a_x*b_w + a_w*b_x - a_z*b_y + a_y*b_z;
+    out[2] = a_y*b_w + a_z*b_x + a_w*b_y - a_x*b_z;
+    out[3] = a_z*b_w - a_y*b_x + a_x*b_y + a_w*b_z;
+}
+// dualquat_mul, out may alias a or b
+template<typename qScalar, typename Scalar1, typename Scalar2>
+constexpr inline void dualquat_mul(const Scalar1* a, const Scalar2* b, qScalar* out) noexcept {
+    qScalar real[4], dual1[4], dual2[4];
+    quat_mul(a, b, real);
+    quat_mul(a, b + 4, dual1);
+    quat_mul(a + 4, b, dual2);
+    for (int i=0; i<4; ++i) {
+        out[i] = real[i];
+        out[i+4] = dual1[i] + dual2[i];
+    }
+}
+// dualquat_unit_error, squared deviation from the unit constraints |real| = 1 and real . dual = 0
+template<typename qScalar>
+constexpr inline qScalar dualquat_unit_error(const qScalar* dq) noexcept {
+    const qScalar real_norm2 = dq[0]*dq[0] + dq[1]*dq[1] + dq[2]*dq[2] + dq[3]*dq[3];
+    const qScalar real_dot_dual = dq[0]*dq[4] + dq[1]*dq[5] + dq[2]*dq[6] + dq[3]*dq[7];
+    return (real_norm2 - 1) * (real_norm2 - 1) + real_dot_dual * real_dot_dual;
+}
+// dualquat_renormalize, projects back onto the unit Dual Quaternions
+template<typename qScalar>
+constexpr inline void dualquat_renormalize(qScalar* dq) {
+    const qScalar real_norm = std::sqrt(dq[0]*dq[0] + dq[1]*dq[1] + dq[2]*dq[2] + dq[3]*dq[3]);
+    if (real_norm == 0) {
+        throw std::runtime_error("Error: dualquat_renormalize() Cannot normalize a 0 Dual Quaternion.");
+    }
+    const qScalar inv_norm = 1 / real_norm;
+    for (int i=0; i<8; ++i) {
+        dq[i] *= inv_norm;
+    }
+    // remove the component of the dual part along the real part
+    const qScalar real_dot_dual = dq[0]*dq[4] + dq[1]*dq[5] + dq[2]*dq[6] + dq[3]*dq[7];
+    for (int i=0; i<4; ++i) {
+        dq[i+4] -= real_dot_dual * dq[i];
+    }
+}
+
+// rsqrt, 1 / sqrt(x) without division or square root: the bit level estimate, relative error below 3.5e-2, refined by
+// Newton-Raphson steps y (3 - x y^2) / 2 that each about square the error, 3 for float and 4 for double, leave only the
+// rounding error, a few ulp; other scalars use 1 / sqrt(x); the result for 0, negative or subnormal x is unspecified
+template<typename qScalar>
+constexpr inline qScalar rsqrt(const qScalar x) noexcept {
+    if constexpr (std::is_same_v<qScalar, float> && std::numeric_limits<float>::is_iec559) {
+        float y = std::bit_cast<float>(std::uint32_t(0x5f375a86) - (std::bit_cast<std::uint32_t>(x) >> 1));
+        const float half_x = 0.5f * x;
+        for (int step=0; step<3; ++step) y *= 1.5f - half_x * y * y;
+        return y;
+    } else if constexpr (std::is_same_v<qScalar, double> && std::numeric_limits<double>::is_iec559) {
+        double y = std::bit_cast<double>(std::uint64_t(0x5fe6eb50c7b537a9) - (std::bit_cast<std::uint64_t>(x) >> 1));
+        const double half_x = 0.5 * x;
+        for (int step=0; step<4; ++step) y *= 1.5 - half_x * y * y;
+        return y;
+    } else {
+        return 1 / std::sqrt(x);
+    }
+}
+// near_unit_limit, |x - 1| up to which (3 - x) / 2, the first order expansion of 1 / sqrt(x) at 1, is exact to the
+// scalar epsilon, its relative error being 3/8 (x - 1)^2 to leading order
+template<typename qScalar>
+inline qScalar near_unit_limit() noexcept {
+    static const qScalar limit = std::sqrt(2 * std::numeric_limits<qScalar>::epsilon());
+    return limit;
+}
+// normalize_factors, turns count squared norms into the factors 1 / |q| by the method
+template<typename qScalar>
+inline void normalize_factors(qScalar* norm2, const std::size_t count, const NormalizeMethod method) noexcept {
+    switch (method) {
+        case NormalizeMethod::Fast:
+            for (std::size_t i=0; i<count; ++i) norm2[i] = rsqrt(norm2[i]);
+            break;
+        case NormalizeMethod::NearUnit: {
+            // first order everywhere, vectorized, then the exact root for the few elements past the limit
+            const qScalar limit = near_unit_limit<qScalar>();
+            bool far = false;
+            for (std::size_t i=0; i<count; ++i) {
+                const qScalar delta = norm2[i] - 1;
+                far |= !(std::abs(delta) <= limit);
+            }
+            if (far) {
+                for (std::size_t i=0; i<count; ++i) {
+                    norm2[i] = std::abs(norm2[i] - 1) <= limit ? (3 - norm2[i]) / 2 : 1 / std::sqrt(norm2[i]);
+                }
+            } else {
+                for (std::size_t i=0; i<count; ++i) norm2[i] = (3 - norm2[i]) / 2;
+            }
+            break;
+        }
+        default:
+            for (std::size_t i=0; i<count; ++i) norm2[i] = 1 / std::sqrt(norm2[i]);
+    }
+}
+// normalize_soa, normalizes size elements stored as Components arrays, 4 for Quaternions, scaled to |q| = 1, or 8 for
+// Dual Quaternions, also projected to real . dual = 0 like dualquat_renormalize, computed in qScalar blocks;
+// elements with a 0 real part are not unit afterwards; factors_of(norm2, count, method) stands in for normalize_factors
+template<int Components, typename qScalar, typename Scalar, typename Factors>
+inline void normalize_soa(Scalar* const* data, const std::size_t size, const NormalizeMethod method, Factors&& factors_of) noexcept {
+    static_assert(Components == 4 || Components == 8, "normalize_soa() takes Quaternions or Dual Quaternions");
+    constexpr std::size_t block = 256;
+    qScalar factors[block];
+    for (std::size_t first=0; first<size; first+=block) {
+        const std::size_t count = std::min(block, size - first);
+        for (std::size_t i=0; i<count; ++i) {
+            qScalar norm2 = 0;
+            for (int k=0; k<4; ++k) {
+                const qScalar r = static_cast<qScalar>(data[k][first + i]);
+                norm2 += r * r;
+            }
+            factors[i] = norm2;
+        }
+        factors_of(factors, count, method);
+        for (std::size_t i=0; i<count; ++i) {
+            qScalar x[8];
+            for (int k=0; k<Components; ++k) x[k] = static_cast<qScalar>(data[k][first + i]) * factors[i];
+            if constexpr (Components == 8) {
+                const qScalar real_dot_dual = x[0]*x[4] + x[1]*x[5] + x[2]*x[6] + x[3]*x[7];
+                for (int k=0; k<4; ++k) x[k+4] -= real_dot_dual * x[k];
+            }
+            for (int k=0; k<Components; ++k) data[k][first + i] = static_cast<Scalar>(x[k]);
+        }
+    }
+}
+template<int Components, typename qScalar, typename Scalar>
+inline void normalize_soa(Scalar* const* data, const std::size_t size, const NormalizeMethod method) noexcept {
+    normalize_soa<Components, qScalar>(data, size, method, [](qScalar* norm2, const std::size_t count, const NormalizeMethod m) {
+        normalize_factors(norm2, count, m);
+    });
+}
+
+// quat_rotate, v' = v + w t + q x t with t = 2 q x v, for a unit Quaternion, out3 may alias v3
+template<typename qScalar, typename Scalar1, typename Scalar2>
+constexpr inline void quat_rotate(const Scalar1* q, const Scalar2* v3, qScalar* out3) noexcept {
+    const qScalar w = static_cast<qScalar>(q[0]);
+    const qScalar x = static_cast<qScalar>(q[1]);
+    const qScalar y = static_cast<qScalar>(q[2]);
+    const qScalar z = static_cast<qScalar>(q[3]);
+    const qScalar v_x = static_cast<qScalar>(v3[0]);
+    const qScalar v_y = static_cast<qScalar>(v3[1]);
+    const qScalar v_z = static_cast<qScalar>(v3[2]);
+    const qScalar t_x = 2 * (y*v_z - z*v_y);
+    const qScalar t_y = 2 * (z*v_x - x*v_z);
+    const qScalar t_z = 2 * (x*v_y - y*v_x);
+    out3[0] = v_x + w*t_x + (y*t_z - z*t_y);
+    out3[1] = v_y + w*t_y + (z*t_x - x*t_z);
+    out3[2] = v_z + w*t_z + (x*t_y - y*t_x);
+}
+// quat_inverse_rotate, rotates by the conjugate of a unit Quaternion, out3 may alias v3
+template<typename qScalar, typename Scalar1, typename Scalar2>
+constexpr inline void quat_inverse_rotate(const Scalar1* q, const Scalar2* v3, qScalar* out3) noexcept {
+    const qScalar conj[4] = { static_cast<qScalar>(q[0]), -static_cast<qScalar>(q[1]), -static_cast<qScalar>(q[2]), -static_cast<qScalar>(q[3]) };
+    quat_rotate(conj, v3, out3);
+}
+// dualquat_translation, t = 2 dual real*, expanded for a unit Dual Quaternion
+template<typename qScalar, typename Scalar>
+constexpr inline void dualquat_translation(const Scalar* dq, qScalar* t3) noexcept {
+    const qScalar r_w = static_cast<qScalar>(dq[0]);
+    const qScalar r_x = static_cast<qScalar>(dq[1]);
+    const qScalar r_y = static_cast<qScalar>(dq[2]);
+    const qScalar r_z = static_cast<qScalar>(dq[3]);
+    const qScalar d_w = static_cast<qScalar>(dq[4]);
+    const qScalar d_x = static_cast<qScalar>(dq[5]);
+    const qScalar d_y = static_cast<qScalar>(dq[6]);
+    const qScalar d_z = static_cast<qScalar>(dq[7]);
+    t3[0] = 2 * (r_w*d_x - d_w*r_x + r_y*d_z - r_z*d_y);
+    t3[1] = 2 * (r_w*d_y - d_w*r_y + r_z*d_x - r_x*d_z);
+    t3[2] = 2 * (r_w*d_z - d_w*r_z + r_x*d_y - r_y*d_x);
+}
+// dualquat_conj, Quaternion conjugate of both parts, the inverse of a unit Dual Quaternion
+template<typename qScalar, typename Scalar>
+constexpr inline void dualquat_conj(const Scalar* dq, qScalar* out) noexcept {
+    for (int i=0; i<8; ++i) {
+        out[i] = (i % 4 == 0) ? static_cast<qScalar>(dq[i]) : -static_cast<qScalar>(dq[i]);
+    }
+}
+// dualquat_tangent, the vector parts of DualQuat::log for a unit Dual Quaternion,
+// half the rotation vector then real* dual, with atan2 in place of acos for accuracy near identity
+template<typename qScalar, typename Scalar>
+constexpr inline void dualquat_tangent(const Scalar* dq, qScalar* v6) noexcept {
+    const qScalar r_w = static_cast<qScalar>(dq[0]);
+    const qScalar r_x = static_cast<qScalar>(dq[1]);
+    const qScalar r_y = static_cast<qScalar>(dq[2]);
+    const qScalar r_z = static_cast<qScalar>(dq[3]);
+    const qScalar d_w = static_cast<qScalar>(dq[4]);
+    const qScalar d_x = static_cast<qScalar>(dq[5]);
+    const qScalar d_y = static_cast<qScalar>(dq[6]);
+    const qScalar d_z = static_cast<qScalar>(dq[7]);
+    const qScalar vec3_norm = std::sqrt(r_x*r_x + r_y*r_y + r_z*r_z);
+    const qScalar scale = vec3_norm == 0 ? 1 / r_w : std::atan2(vec3_norm, r_w) / vec3_norm;
+    v6[0] = scale * r_x;
+    v6[1] = scale * r_y;
+    v6[2] = scale * r_z;
+    v6[3] = r_w*d_x - d_w*r_x - (r_y*d_z - r_z*d_y);
+    v6[4] = r_w*d_y - d_w*r_y - (r_z*d_x - r_x*d_z);
+    v6[5] = r_w*d_z - d_w*r_z - (r_x*d_y - r_y*d_x);
+}
+// dualquat_from_tangent, inverse of dualquat_tangent, real = exp(v6[0:3]), dual = real (0, v6[3:6])
+template<typename qScalar, typename Scalar>
+constexpr inline void dualquat_from_tangent(const Scalar* v6, qScalar* dq) noexcept {
+    const qScalar a_x = static_cast<qScalar>(v6[0]);
+    const qScalar a_y = static_cast<qScalar>(v6[1]);
+    const qScalar a_z = static_cast<qScalar>(v6[2]);
+    const qScalar angle2 = a_x*a_x + a_y*a_y + a_z*a_z;
+    const qScalar angle = std::sqrt(angle2);
+    // sin(angle) / angle, Taylor expanded where the quotient loses accuracy
+    const qScalar sinc = angle2 < qScalar(1e-8) ? 1 - angle2 / 6 : std::sin(angle) / angle;
+    dq[0] = std::cos(angle);
+    dq[1] = sinc * a_x;
+    dq[2] = sinc * a_y;
+    dq[3] = sinc * a_z;
+    const qScalar b[4] = { 0, static_cast<qScalar>(v6[3]), static_cast<qScalar>(v6[4]), static_cast<qScalar>(v6[5]) };
+    quat_mul(dq, b, dq + 4);
+}
+// screw_series_bound, squared angle below which the Taylor expansions of the screw exp and log are exact to the scalar epsilon
+template<typename qScalar>
+inline qScalar screw_series_bound() noexcept {
+    static const qScalar bound = std::cbrt(720 * std::numeric_limits<qScalar>::epsilon());
+    return bound;
+}
+// pure_dualquat_exp, the screw exponential of the pure Dual Quaternion (0, a) + ϵ (0, b) given as v6 = { a, b },
+// real = (cos h, sin h / h a), dual = (- sin h / h a.b, sin h / h b + (h cos h - sin h) / h^3 (a.b) a) with h = |a|,
+// small angles use the Taylor expansions and no trigonometric call
+template<typename qScalar, typename Scalar>
+inline void pure_dualquat_exp(const Scalar* v6, qScalar* dq) noexcept {
+    const qScalar a[3] = { static_cast<qScalar>(v6[0]), static_cast<qScalar>(v6[1]), static_cast<qScalar>(v6[2]) };
+    const qScalar b[3] = { static_cast<qScalar>(v6[3]), static_cast<qScalar>(v6[4]), static_cast<qScalar>(v6[5]) };
+    const qScalar h2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+    const qScalar a_dot_b = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    qScalar cos_h, sinc_h, coef;
+    if (h2 < screw_series_bound<qScalar>()) {
+        cos_h = 1 - h2 / 2 + h2 * h2 / 24;
+        sinc_h = 1 - h2 / 6 + h2 * h2 / 120;
+        coef = - qScalar(1) / 3 + h2 / 30 - h2 * h2 / 840;
+    } else {
+        const qScalar h = std::sqrt(h2);
+        const qScalar sin_h = std::sin(h);
+        cos_h = std::cos(h);
+        sinc_h = sin_h / h;
+        coef = (h * cos_h - sin_h) / (h2 * h);
+    }
+    dq[0] = cos_h;
+    dq[4] = - sinc_h * a_dot_b;
+    for (int i=0; i<3; ++i) {
+        dq[i+1] = sinc_h * a[i];
+        dq[i+5] = sinc_h * b[i] + coef * a_dot_b * a[i];
+    }
+}
+// unit_dualquat_log, the screw logarithm of a unit Dual Quaternion as v6 = { a, b } of the pure result (0, a) + ϵ (0, b),
+// a = h / s rv, b = h / s dv + (h c - s) / s^3 dw rv with c = rw, s = |rv|, h = atan2(s, c), inverse of pure_dualquat_exp;
+// small angles use the Taylor expansions in t = s / c; dq and -dq are the same pose and give the same logarithm, that of
+// the sign with c >= 0, so the rotation angle is at most pi and -1 + ϵ d keeps its translation
+template<typename qScalar, typename Scalar>
+inline void unit_dualquat_log(const Scalar* dq, qScalar* v6) noexcept {
+    const qScalar sign = static_cast<qScalar>(dq[0]) < 0 ? -1 : 1;
+    const qScalar c = sign * static_cast<qScalar>(dq[0]);
+    const qScalar rv[3] = { sign * static_cast<qScalar>(dq[1]), sign * static_cast<qScalar>(dq[2]), sign * static_cast<qScalar>(dq[3]) };
+    const qScalar d_w = sign * static_cast<qScalar>(dq[4]);
+    const qScalar dv[3] = { sign * static_cast<qScalar>(dq[5]), sign * static_cast<qScalar>(dq[6]), sign * static_cast<qScalar>(dq[7]) };
+    const qScalar s2 = rv[0]*rv[0] + rv[1]*rv[1] + rv[2]*rv[2];
+    qScalar h_over_s, coef;
+    if (c > 0 && s2 < screw_series_bound<qScalar>() * c * c) {
+        // atan(t) / t and (atan(t) / t - 1) / t^2
+        const qScalar t2 = s2 / (c * c);
+        h_over_s = (1 - t2 / 3 + t2 * t2 / 5 - t2 * t2 * t2 / 7) / c;
+        coef = (- qScalar(1) / 3 + t2 / 5 - t2 * t2 / 7 + t2 * t2 * t2 / 9) / (c * c);
+    } else if (s2 == 0) {
+        h_over_s = 0;
+        coef = 0;
+    } else {
+        const qScalar s = std::sqrt(s2);
+        const qScalar h = std::atan2(s, c);
+        h_over_s = h / s;
+        coef = (h * c - s) / (s2 * s);
+    }
+    for (int i=0; i<3; ++i) {
+        v6[i] = h_over_s * rv[i];
+        v6[i+3] = h_over_s * dv[i] + coef * d_w * rv[i];
+    }
+}
+// unit_dualquat_interpolate, the screw motion interpolation a exp(s log(a* b)) of unit Dual Quaternions along the shorter
+// rotation, which unit_dualquat_log takes, out may alias a or b
+template<typename qScalar, typename Scalar>
+inline void unit_dualquat_interpolate(const Scalar* a, const Scalar* b, const qScalar s, qScalar* out) noexcept {
+    qScalar start[8], relative[8], v6[6], step[8];
+    for (int i=0; i<8; ++i) start[i] = static_cast<qScalar>(a[i]);
+    dualquat_conj(start, relative);
+    dualquat_mul(relative, b, relative);
+    unit_dualquat_log(relative, v6);
+    for (int i=0; i<6; ++i) v6[i] *= s;
+    pure_dualquat_exp(v6, step);
+    dualquat_mul(start, step, out);
+}
+// quat_to_matrix, writes the 3x3 rotation matrix of a unit Quaternion, m(i,j) = m[i*row_stride + j*col_stride]
+template<typename qScalar, typename Scalar>
+constexpr inline void quat_to_matrix(const Scalar* q, qScalar* m, const std::size_t row_stride, const std::size_t col_stride) noexcept {
+    const qScalar w = static_cast<qScalar>(q[0]);
+    const qScalar x = static_cast<qScalar>(q[1]);
+    const qScalar y = static_cast<qScalar>(q[2]);
+    const qScalar z = static_cast<qScalar>(q[3]);
+    const qScalar xx = x*x, yy = y*y, zz = z*z;
+    const qScalar xy = x*y, xz = x*z, yz = y*z;
+    const qScalar wx = w*x, wy = w*y, wz = w*z;
+    m[0*row_stride + 0*col_stride] = 1 - 2 * (yy + zz);
+    m[0*row_stride + 1*col_stride] = 2 * (xy - wz);
+    m[0*row_stride + 2*col_stride] = 2 * (xz + wy);
+    m[1*row_stride + 0*col_stride] = 2 * (xy + wz);
+    m[1*row_stride + 1*col_stride] = 1 - 2 * (xx + zz);
+    m[1*row_stride + 2*col_stride] = 2 * (yz - wx);
+    m[2*row_stride + 0*col_stride] = 2 * (xz - wy);
+    m[2*row_stride + 1*col_stride] = 2 * (yz + wx);
+    m[2*row_stride + 2*col_stride] = 1 - 2 * (xx + yy);
+}
+// matrix_to_quat, Shepperd's method, pivots on the largest of the trace and the diagonal
+template<typename qScalar, typename Scalar>
+constexpr inline void matrix_to_quat(const Scalar* m, qScalar* q, const std::size_t row_stride, const std::size_t col_stride) noexcept {
+    const auto at = [&](const std::size_t i, const std::size_t j) { return static_cast<qScalar>(m[i*row_stride + j*col_stride]); };
+    const qScalar m00 = at(0,0), m11 = at(1,1), m22 = at(2,2);
+    const qScalar trace = m00 + m11 + m22;
+    if (trace >= m00 && trace >= m11 && trace >= m22) {
+        const qScalar s = 2 * std::sqrt(1 + trace);
+        q[0] = s / 4;
+        q[1] = (at(2,1) - at(1,2)) / s;
+        q[2] = (at(0,2) - at(2,0)) / s;
+        q[3] = (at(1,0) - at(0,1)) / s;
+    } else if (m00 >= m11 && m00 >= m22) {
+        const qScalar s = 2 * std::sqrt(1 + m00 - m11 - m22);
+        q[0] = (at(2,1) - at(1,2)) / s;
+        q[1] = s / 4;
+        q[2] = (at(0,1) + at(1,0)) / s;
+        q[3] = (at(0,2) + at(2,0)) / s;
+    } else if (m11 >= m22) {
+        const qScalar s = 2 * std::sqrt(1 - m00 + m11 - m22);
+        q[0] = (at(0,2) - at(2,0)) / s;
+        q[1] = (at(0,1) + at(1,0)) / s;
+        q[2] = s / 4;
+        q[3] = (at(1,2) + at(2,1)) / s;
+    } else {
+        const qScalar s = 2 * std::sqrt(1 - m00 - m11 + m22);
+        q[0] = (at(1,0) - at(0,1)) / s;
+        q[1] = (at(0,2) + at(2,0)) / s;
+        q[2] = (at(1,2) + at(2,1)) / s;
+        q[3] = s / 4;
+    }
+}
+// dualquat_to_matrix, writes the 4x4 homogeneous transform of a unit Dual Quaternion
+template<typename qScalar, typename Scalar>
+constexpr inline void dualquat_to_matrix(const Scalar* dq, qScalar* m, const std::size_t row_stride, const std::size_t col_stride) noexcept {
+    quat_to_matrix(dq, m, row_stride, col_stride);
+    qScalar t3[3];
+    dualquat_translation(dq, t3);
+    for (std::size_t i=0; i<3; ++i) {
+        m[i*row_stride + 3*col_stride] = t3[i];
+        m[3*row_stride + i*col_stride] = 0;
+    }
+    m[3*row_stride + 3*col_stride] = 1;
+}
+// matrix_to_dualquat, reads a 4x4 homogeneous transform, dual = 0.5 t real
+template<typename qScalar, typename Scalar>
+constexpr inline void matrix_to_dualquat(const Scalar* m, qScalar* dq, const std::size_t row_stride, const std::size_t col_stride) noexcept {
+    matrix_to_quat(m, dq, row_stride, col_stride);
+    const qScalar r_norm = std::sqrt(dq[0]*dq[0] + dq[1]*dq[1] + dq[2]*dq[2] + dq[3]*dq[3]);
+    for (int i=0; i<4; ++i) {
+        dq[i] /= r_norm;
+    }
+    const qScalar t3[4] = { 0,
+                            static_cast<qScalar>(m[0*row_stride + 3*col_stride]) / 2,
+                            static_cast<qScalar>(m[1*row_stride + 3*col_stride]) / 2,
+                            static_cast<qScalar>(m[2*row_stride + 3*col_stride]) / 2 };
+    quat_mul(t3, dq, dq + 4);
+}
+// matrix_strides, row and column strides of an n x n matrix
+constexpr inline void matrix_strides(const MatrixLayout layout, const std::size_t n, std::size_t& row_stride, std::size_t& col_stride) noexcept {
+    row_stride = layout == MatrixLayout::RowMajor ? n : 1;
+    col_stride = layout == MatrixLayout::RowMajor ? 1 : n;
+}
+
+}  // namespace kernel
+
+}  // namespace dqpose
@@ -0,0 +1,392 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/linalg.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining small dense linear algebra
+ *
+ *     This file provides the fixed-size routines the solvers are built
+ *     on. Matrices are row-major std::arrays of N*N scalars.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <queue>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+namespace dqpose
+{
+
+namespace linalg
+{
+
+// cholesky, in-place lower factor L of a symmetric positive definite matrix, false if it is not
+template<std::size_t N, typename qScalar>
+constexpr inline bool cholesky(std::array<qScalar, N*N>& a) noexcept {
+    for (std::size_t j=0; j<N; ++j) {
+        qScalar diag = a[j*N + j];
+        for (std::size_t k=0; k<j; ++k) {
+            diag -= a[j*N + k] * a[j*N + k];
+        }
+        if (!(diag > 0)) {
+            return false;
+        }
+        diag = std::sqrt(diag);
+        a[j*N + j] = diag;
+        for (std::size_t i=j+1; i<N; ++i) {
+            qScalar sum = a[i*N + j];
+            for (std::size_t k=0; k<j; ++k) {
+                sum -= a[i*N + k] * a[j*N + k];
+            }
+            a[i*N + j] = sum / diag;
+        }
+        for (std::size_t i=0; i<j; ++i) {
+            a[i*N + j] = 0;
+        }
+    }
+    return true;
+}
+// cholesky_solve, solves L L^T x = b in place with the factor from cholesky
+template<std::size_t N, typename qScalar>
+constexpr inline void cholesky_solve(const std::array<qScalar, N*N>& l, qScalar* b) noexcept {
+    for (std::size_t i=0; i<N; ++i) {
+        qScalar sum = b[i];
+        for (std::size_t k=0; k<i; ++k) {
+            sum -= l[i*N + k] * b[k];
+        }
+        b[i] = sum / l[i*N + i];
+    }
+    for (std::size_t i=N; i-- > 0; ) {
+        qScalar sum = b[i];
+        for (std::size_t k=i+1; k<N; ++k) {
+            sum -= l[k*N + i] * b[k];
+        }
+        b[i] = sum / l[i*N + i];
+    }
+}
+// mul, y = A x for an R x C matrix
+template<std::size_t R, std::size_t C, typename qScalar>
+constexpr inline void mul(const std::array<qScalar, R*C>& a, const qScalar* x, qScalar* y) noexcept {
+    for (std::size_t i=0; i<R; ++i) {
+        qScalar sum = 0;
+        for (std::size_t j=0; j<C; ++j) {
+            sum += a[i*C + j] * x[j];
+        }
+        y[i] = sum;
+    }
+}
+// mul_transposed, y = A^T x for an R x C matrix
+template<std::size_t R, std::size_t C, typename qScalar>
+constexpr inline void mul_transposed(const std::array<qScalar, R*C>& a, const qScalar* x, qScalar* y) noexcept {
+    for (std::size_t j=0; j<C; ++j) {
+        y[j] = 0;
+    }
+    for (std::size_t i=0; i<R; ++i) {
+        for (std::size_t j=0; j<C; ++j) {
+            y[j] += a[i*C + j] * x[i];
+        }
+    }
+}
+// add_congruence, S += A^T W B for R x C matrices A, B and an R x R matrix W
+template<std::size_t R, std::size_t C, typename qScalar>
+constexpr inline void add_congruence(const std::array<qScalar, R*C>& a, const std::array<qScalar, R*R>& w,
+                                     const std::array<qScalar, R*C>& b, std::array<qScalar, C*C>& s) noexcept {
+    std::array<qScalar, R*C> wb{};
+    for (std::size_t i=0; i<R; ++i) {
+        for (std::size_t k=0; k<R; ++k) {
+            const qScalar w_ik = w[i*R + k];
+            for (std::size_t j=0; j<C; ++j) {
+                wb[i*C + j] += w_ik * b[k*C + j];
+            }
+        }
+    }
+    for (std::size_t k=0; k<R; ++k) {
+        for (std::size_t i=0; i<C; ++i) {
+            const qScalar a_ki = a[k*C + i];
+            for (std::size_t j=0; j<C; ++j) {
+                s[i*C + j] += a_ki * wb[k*C + j];
+            }
+        }
+    }
+}
+// symmetric_eigen, cyclic Jacobi, eigenvalues ascending and the matching unit eigenvectors as columns
+template<std::size_t N, typename qScalar>
+inline void symmetric_eigen(std::array<qScalar, N*N> a, std::array<qScalar, N>& values, std::array<qScalar, N*N>& vectors,
+                            const std::size_t max_sweeps=64) noexcept {
+    vectors.fill(0);
+    for (std::size_t i=0; i<N; ++i) vectors[i*N + i] = 1;
+    for (std::size_t sweep=0; sweep<max_sweeps; ++sweep) {
+        qScalar off = 0, total = 0;
+        for (std::size_t i=0; i<N; ++i) {
+            for (std::size_t j=0; j<N; ++j) {
+                total += a[i*N + j] * a[i*N + j];
+                if (i != j) off += a[i*N + j] * a[i*N + j];
+            }
+        }
+        if (!(off > std::numeric_limits<qScalar>::epsilon() * std::numeric_limits<qScalar>::epsilon() * total)) {
+            break;
+        }
+        for (std::size_t p=0; p<N; ++p) {
+            for (std::size_t q=p+1; q<N; ++q) {
+                const qScalar apq = a[p*N + q];
+                if (apq == 0) continue;
+                const qScalar theta = (a[q*N + q] - a[p*N + p]) / (2 * apq);
+                const qScalar t = (theta < 0 ? -1 : 1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                const qScalar c = 1 / std::sqrt(t * t + 1);
+                const qScalar s = t * c;
+                // A = P^T A P, V = V P
+                for (std::size_t k=0; k<N; ++k) {
+                    const qScalar akp = a[k*N + p], akq = a[k*N + q];
+                    a[k*N + p] = c * akp - s * akq;
+                    a[k*N + q] = s * akp + c * akq;
+                }
+                for (std::size_t k=0; k<N; ++k) {
+                    const qScalar apk = a[p*N + k], aqk = a[q*N + k];
+                    a[p*N + k] = c * apk - s * aqk;
+                    a[q*N + k] = s * apk + c * aqk;
+                }
+                for (std::size_t k=0; k<N; ++k) {
+                    const qScalar vkp = vectors[k*N + p], vkq = vectors[k*N + q];
+                    vectors[k*N + p] = c * vkp - s * vkq;
+                    vectors[k*N + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    // selection sort of the eigen pairs
+    for (std::size_t i=0; i<N; ++i) values[i] = a[i*N + i];
+    for (std::size_t i=0; i<N; ++i) {
+        std::size_t min = i;
+        for (std::size_t j=i+1; j<N; ++j) {
+            if (values[j] < values[min]) min = j;
+        }
+        if (min == i) continue;
+        std::swap(values[i], values[min]);
+        for (std::size_t k=0; k<N; ++k) std::swap(vectors[k*N + i], vectors[k*N + min]);
+    }
+}
+
+// BlockCholesky, sparse L L^T factorization of a symmetric positive definite matrix made of N x N blocks
+template<std::size_t N, typename qScalar>
+class BlockCholesky {
+public:
+using Block = std::array<qScalar, N*N>;
+protected:
+    // _order[k] is the variable eliminated k-th, _position its inverse
+    std::vector<std::size_t> _order;
+    std::vector<std::size_t> _position;
+    // below-diagonal block rows of every column, as elimination positions, and their blocks
+    std::vector<std::vector<std::size_t>> _rows;
+    std::vector<std::vector<Block>> _blocks;
+    std::vector<Block> _diagonal;
+
+    // _find, block (row, col) of the lower factor, row > col as positions
+    inline Block& _find(const std::size_t row, const std::size_t col) {
+        const auto& rows = _rows[col];
+        const auto it = std::lower_bound(rows.begin(), rows.end(), row);
+        return _blocks[col][static_cast<std::size_t>(it - rows.begin())];
+    }
+public:
+    // Default Constructor
+    explicit BlockCholesky() noexcept
+        : _order{ }, _position{ }, _rows{ }, _blocks{ }, _diagonal{ } {
+
+    }
+    // size
+    inline std::size_t size() const noexcept { return _order.size(); }
+    // nonzero_blocks, below-diagonal blocks of the factor
+    inline std::size_t nonzero_blocks() const noexcept {
+        std::size_t res = 0;
+        for (const auto& rows : _rows) res += rows.size();
+        return res;
+    }
+    // analyze, minimum degree ordering and symbolic factorization of the pattern of the off-diagonal block pairs
+    inline void analyze(const std::size_t size, const std::vector<std::pair<std::size_t, std::size_t>>& pairs) {
+        std::vector<std::vector<std::size_t>> adjacency(size);
+        for (const auto& pair : pairs) {
+            if (pair.first == pair.second) continue;
+            adjacency[pair.first].push_back(pair.second);
+            adjacency[pair.second].push_back(pair.first);
+        }
+        for (auto& neighbors : adjacency) {
+            std::sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        }
+        // elimination game, the neighbors of an eliminated variable become a clique
+        using Entry = std::pair<std::size_t, std::size_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        for (std::size_t i=0; i<size; ++i) queue.emplace(adjacency[i].size(), i);
+        std::vector<std::uint8_t> eliminated(size, 0);
+        std::vector<std::vector<std::size_t>> patterns(size);
+        _order.clear();
+        _order.reserve(size);
+        std::vector<std::size_t> merged;
+        while (!queue.empty()) {
+            const auto [degree, v] = queue.top();
+            queue.pop();
+            if (eliminated[v] || degree != adjacency[v].size()) continue;
+            eliminated[v] = 1;
+            _order.push_back(v);
+            const std::vector<std::size_t>& clique = adjacency[v];
+            for (const std::size_t u : clique) {
+                merged.clear();
+                std::set_union(adjacency[u].begin(), adjacency[u].end(), clique.begin(), clique.end(), std::back_inserter(merged));
+                merged.erase(std::remove_if(merged.begin(), merged.end(), [&](const std::size_t w) { return w == u || w == v; }), merged.end());
+                adjacency[u].swap(merged);
+                queue.emplace(adjacency[u].size(), u);
+            }
+            patterns[v].swap(adjacency[v]);
+        }
+        _position.assign(size, 0);
+        for (std::size_t k=0; k<size; ++k) _position[_order[k]] = k;
+        _rows.assign(size, { });
+        _blocks.assign(size, { });
+        _diagonal.assign(size, Block{ });
+        for (std::size_t k=0; k<size; ++k) {
+            auto& rows = _rows[k];
+            for (const std::size_t u : patterns[_order[k]]) rows.push_back(_position[u]);
+            std::sort(rows.begin(), rows.end());
+            _blocks[k].assign(rows.size(), Block{ });
+        }
+    }
+    // reset, zeroes the numeric values and keeps the pattern
+    inline void reset() noexcept {
+        for (auto& block : _diagonal) block.fill(0);
+        for (auto& blocks : _blocks) {
+            for (auto& block : blocks) block.fill(0);
+        }
+    }
+    // add_diagonal, A(i, i) += block
+    inline void add_diagonal(const std::size_t i, const Block& block) noexcept {
+        Block& target = _diagonal[_position[i]];
+        for (std::size_t k=0; k<N*N; ++k) target[k] += block[k];
+    }
+    // add_off_diagonal, A(i, j) += block and A(j, i) += block^T, the pair must have been analyzed
+    inline void add_off_diagonal(const std::size_t i, const std::size_t j, const Block& block) {
+        const std::size_t p_i = _position[i];
+        const std::size_t p_j = _position[j];
+        if (p_i > p_j) {
+            Block& target = _find(p_i, p_j);
+            for (std::size_t k=0; k<N*N; ++k) target[k] += block[k];
+        } else {
+            Block& target = _find(p_j, p_i);
+            for (std::size_t r=0; r<N; ++r) {
+                for (std::size_t c=0; c<N; ++c) target[r*N + c] += block[c*N + r];
+            }
+        }
+    }
+    // factorize, right-looking, false if the matrix is not positive definite
+    inline bool factorize() {
+        const std::size_t size = _order.size();
+        for (std::size_t k=0; k<size; ++k) {
+            Block& diagonal = _diagonal[k];
+            if (!cholesky<N>(diagonal)) {
+                return false;
+            }
+            // L(i, k) = A(i, k) L(k, k)^-T, row by row forward substitution
+            for (Block& block : _blocks[k]) {
+                for (std::size_t r=0; r<N; ++r) {
+                    for (std::size_t c=0; c<N; ++c) {
+                        qScalar sum = block[r*N + c];
+                        for (std::size_t m=0; m<c; ++m) sum -= block[r*N + m] * diagonal[c*N + m];
+                        block[r*N + c] = sum / diagonal[c*N + c];
+                    }
+                }
+            }
+            // A(i, j) -= L(i, k) L(j, k)^T for every pair of rows i >= j of column k
+            const auto& rows = _rows[k];
+            for (std::size_t b=0; b<rows.size(); ++b) {
+                const Block& l_j = _blocks[k][b];
+                for (std::size_t a=b; a<rows.size(); ++a) {
+                    const Block& l_i = _blocks[k][a];
+                    Block& target = a == b ? _diagonal[rows[a]] : _find(rows[a], rows[b]);
+                    for (std::size_t r=0; r<N; ++r) {
+                        for (std::size_t c=0; c<N; ++c) {
+                            qScalar sum = 0;
+                            for (std::size_t m=0; m<N; ++m) sum += l_i[r*N + m] * l_j[c*N + m];
+                            target[r*N + c] -= sum;
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+    // solve, A x = b in place, b holds N scalars per variable in variable order
+    inline void solve(qScalar* b) const {
+        const std::size_t size = _order.size();
+        std::vector<qScalar> y(size * N);
+        for (std::size_t k=0; k<size; ++k) {
+            std::copy(b + _order[k]*N, b + _order[k]*N + N, y.begin() + k*N);
+        }
+        // L y = b
+        for (std::size_t k=0; k<size; ++k) {
+            qScalar* y_k = y.data() + k*N;
+            const Block& diagonal = _diagonal[k];
+            for (std::size_t r=0; r<N; ++r) {
+                qScalar sum = y_k[r];
+                for (std::size_t m=0; m<r; ++m) sum -= diagonal[r*N + m] * y_k[m];
+                y_k[r] = sum / diagonal[r*N + r];
+            }
+            for (std::size_t a=0; a<_rows[k].size(); ++a) {
+                qScalar* y_i = y.data() + _rows[k][a]*N;
+                const Block& block = _blocks[k][a];
+                for (std::size_t r=0; r<N; ++r) {
+                    for (std::size_t m=0; m<N; ++m) y_i[r] -= block[r*N + m] * y_k[m];
+                }
+            }
+        }
+        // L^T x = y
+        for (std::size_t k=size; k-- > 0; ) {
+            qScalar* x_k = y.data() + k*N;
+            for (std::size_t a=0; a<_rows[k].size(); ++a) {
+                const qScalar* x_i = y.data() + _rows[k][a]*N;
+                const Block& block = _blocks[k][a];
+                for (std::size_t r=0; r<N; ++r) {
+                    for (std::size_t m=0; m<N; ++m) x_k[m] -= block[r*N + m] * x_i[r];
+                }
+            }
+            const Block& diagonal = _diagonal[k];
+            for (std::size_t r=N; r-- > 0; ) {
+                qScalar sum = x_k[r];
+                for (std::size_t m=r+1; m<N; ++m) sum -= diagonal[m*N + r] * x_k[m];
+                x_k[r] = sum / diagonal[r*N + r];
+            }
+        }
+        for (std::size_t k=0; k<size; ++k) {
+            std::copy(y.begin() + k*N, y.begin() + k*N + N, b + _order[k]*N);
+        }
+    }
+};
+
+}  // namespace linalg
+
+}  // namespace dqpose
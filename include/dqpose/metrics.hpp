@@ -0,0 +1,333 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/metrics.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining trajectory error metrics
+ *
+ *     This file provides the rotation and translation errors between pairs
+ *     of unit Dual Quaternions, per pair, a^-1 b, or per relative motion
+ *     over a fixed offset, and ErrorStatistics, a mergeable streaming
+ *     summary holding the count, mean, RMSE, max and percentiles.
+ *
+ *     The error of a^-1 b needs no Dual Quaternion product: its rotation
+ *     angle follows from the real parts alone and its translation norm is
+ *     the distance between the translations. MetricForm::Proxy skips the
+ *     asin and sqrt and reports the squared sine of half the angle, the
+ *     squared vector part of ra* rb, and the squared distance. Both are
+ *     monotone in the exact errors, so thresholds, max and percentiles carry
+ *     over through proxy_to_angle and sqrt, and the mean of the squared
+ *     distances is the translation MSE. Percentiles come from a log-bucketed
+ *     sketch with a bounded relative error, so summaries merge across
+ *     threads and runs.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace dqpose
+{
+
+// MetricForm, exact errors in radians and length units, or their monotone proxies, see metrics.hpp
+enum class MetricForm { Exact, Proxy };
+
+namespace kernel
+{
+
+// pose_error_proxy, sin^2(angle / 2) and |tb - ta|^2 for the unit Dual Quaternions a and b, the proxies of the errors of a^-1 b,
+// sin^2(angle / 2) is the squared vector part of ra* rb, which keeps its accuracy near 0 unlike 1 - (ra . rb)^2
+template<typename qScalar, typename Scalar1, typename Scalar2>
+constexpr inline void pose_error_proxy(const Scalar1* a, const Scalar2* b, qScalar& rotation, qScalar& translation) noexcept {
+    const qScalar a_w = static_cast<qScalar>(a[0]), a_x = static_cast<qScalar>(a[1]), a_y = static_cast<qScalar>(a[2]), a_z = static_cast<qScalar>(a[3]);
+    const qScalar b_w = static_cast<qScalar>(b[0]), b_x = static_cast<qScalar>(b[1]), b_y = static_cast<qScalar>(b[2]), b_z = static_cast<qScalar>(b[3]);
+    const qScalar v_x = a_w*b_x - b_w*a_x - (a_y*b_z - a_z*b_y);
+    const qScalar v_y = a_w*b_y - b_w*a_y - (a_z*b_x - a_x*b_z);
+    const qScalar v_z = a_w*b_z - b_w*a_z - (a_x*b_y - a_y*b_x);
+    qScalar ta[3], tb[3];
+    dualquat_translation(a, ta);
+    dualquat_translation(b, tb);
+    rotation = v_x*v_x + v_y*v_y + v_z*v_z;
+    translation = (tb[0] - ta[0]) * (tb[0] - ta[0]) + (tb[1] - ta[1]) * (tb[1] - ta[1]) + (tb[2] - ta[2]) * (tb[2] - ta[2]);
+}
+// motion_error_proxy, the proxies of the errors of the relative motions a0^-1 a1 and b0^-1 b1
+template<typename qScalar, typename Scalar1, typename Scalar2>
+constexpr inline void motion_error_proxy(const Scalar1* a0, const Scalar1* a1, const Scalar2* b0, const Scalar2* b1,
+                                         qScalar& rotation, qScalar& translation) noexcept {
+    qScalar motion_a[8], motion_b[8];
+    dualquat_conj(a0, motion_a);
+    dualquat_mul(motion_a, a1, motion_a);
+    dualquat_conj(b0, motion_b);
+    dualquat_mul(motion_b, b1, motion_b);
+    pose_error_proxy(motion_a, motion_b, rotation, translation);
+}
+// proxy_to_angle, the rotation angle 2 asin(sqrt(proxy)) of a rotation proxy, accurate near 0 unlike acos
+template<typename qScalar>
+inline qScalar proxy_to_angle(const qScalar proxy) noexcept {
+    return 2 * std::asin(std::sqrt(std::min(qScalar(1), proxy)));
+}
+// finish_errors, converts proxies in place to exact errors unless form is MetricForm::Proxy
+template<typename qScalar>
+inline void finish_errors(qScalar& rotation, qScalar& translation, const MetricForm form) noexcept {
+    if (form == MetricForm::Exact) {
+        rotation = proxy_to_angle(rotation);
+        translation = std::sqrt(translation);
+    }
+}
+
+}  // namespace kernel
+
+template<QuatScalar qScalar>
+class ErrorStatistics {
+protected:
+    std::size_t _count;
+    qScalar _sum;
+    qScalar _sum2;
+    qScalar _max;
+    // sketch, values in (gamma^(k-1), gamma^k] counted in _buckets[k - _first], values of 0 and below in _zeros
+    qScalar _accuracy;
+    qScalar _log_gamma;
+    std::size_t _zeros;
+    std::vector<std::uint64_t> _buckets;
+    long _first;
+
+    // _bucket, the counter of bucket k, growing the sketch as needed
+    inline std::uint64_t& _bucket(const long k) {
+        if (_buckets.empty()) {
+            _first = k;
+            _buckets.resize(1, 0);
+        } else if (k < _first) {
+            _buckets.insert(_buckets.begin(), static_cast<std::size_t>(_first - k), 0);
+            _first = k;
+        } else if (k >= _first + static_cast<long>(_buckets.size())) {
+            _buckets.resize(static_cast<std::size_t>(k - _first + 1), 0);
+        }
+        return _buckets[static_cast<std::size_t>(k - _first)];
+    }
+public:
+    // Default Constructor, percentiles are within the relative accuracy of the exact ones
+    explicit ErrorStatistics(const qScalar accuracy=0.01)
+        : _count( 0 ), _sum( 0 ), _sum2( 0 ), _max( 0 ), _accuracy( accuracy ),
+          _log_gamma( std::log((1 + accuracy) / (1 - accuracy)) ), _zeros( 0 ), _buckets( ), _first( 0 ) {
+        if (!(accuracy > 0 && accuracy < 1)) {
+            throw std::runtime_error("Error: ErrorStatistics() Requires an accuracy in (0, 1).");
+        }
+    }
+    // add, one error, NaN is ignored
+    inline void add(const qScalar value) {
+        if (value != value) return;
+        ++_count;
+        _sum += value;
+        _sum2 += value * value;
+        _max = _count == 1 ? value : std::max(_max, value);
+        if (!(value > std::numeric_limits<qScalar>::min())) {
+            ++_zeros;
+            return;
+        }
+        ++_bucket(static_cast<long>(std::ceil(std::log(value) / _log_gamma)));
+    }
+    // add, size errors
+    inline void add(const qScalar* values, const std::size_t size) {
+        for (std::size_t i=0; i<size; ++i) add(values[i]);
+    }
+    // operator+=, merges summaries of the same accuracy
+    inline ErrorStatistics& operator+=(const ErrorStatistics& other) {
+        if (other._accuracy != _accuracy) {
+            throw std::runtime_error("Error: ErrorStatistics::operator+=() Cannot merge summaries of different accuracy.");
+        }
+        if (other._count == 0) return *this;
+        _max = _count == 0 ? other._max : std::max(_max, other._max);
+        _count += other._count;
+        _sum += other._sum;
+        _sum2 += other._sum2;
+        _zeros += other._zeros;
+        for (std::size_t k=0; k<other._buckets.size(); ++k) {
+            if (other._buckets[k] != 0) _bucket(other._first + static_cast<long>(k)) += other._buckets[k];
+        }
+        return *this;
+    }
+    // clear
+    inline void clear() noexcept {
+        _count = 0;
+        _sum = _sum2 = _max = 0;
+        _zeros = 0;
+        _buckets.clear();
+    }
+    // query
+    inline std::size_t count() const noexcept { return _count; }
+    inline qScalar accuracy() const noexcept { return _accuracy; }
+    inline qScalar max() const noexcept { return _max; }
+    inline qScalar mean() const noexcept { return _count == 0 ? qScalar(0) : _sum / _count; }
+    inline qScalar rmse() const noexcept { return _count == 0 ? qScalar(0) : std::sqrt(_sum2 / _count); }
+    // percentile, p in [0, 100], within the relative accuracy
+    inline qScalar percentile(const qScalar p) const {
+        if (_count == 0) {
+            throw std::runtime_error("Error: ErrorStatistics::percentile() No error added.");
+        }
+        if (!(p >= 0 && p <= 100)) {
+            throw std::runtime_error("Error: ErrorStatistics::percentile() Requires p in [0, 100].");
+        }
+        const std::uint64_t rank = static_cast<std::uint64_t>(p / 100 * (_count - 1));
+        std::uint64_t seen = _zeros;
+        if (rank < seen) return 0;
+        for (std::size_t k=0; k<_buckets.size(); ++k) {
+            seen += _buckets[k];
+            if (rank < seen) {
+                // the value of least relative error in (gamma^(k-1), gamma^k]
+                const qScalar upper = std::exp(_log_gamma * (_first + static_cast<long>(k)));
+                return std::min(_max, upper * (1 - _accuracy));
+            }
+        }
+        return _max;
+    }
+    // median
+    inline qScalar median() const { return percentile(50); }
+};
+
+template<QuatScalar qScalar>
+class TrajectoryErrors {
+public:
+    // rotation errors, angles or proxies
+    ErrorStatistics<qScalar> rotation;
+    // translation errors, distances or squared distances
+    ErrorStatistics<qScalar> translation;
+
+    // Default Constructor
+    explicit TrajectoryErrors(const qScalar accuracy=0.01)
+        : rotation( accuracy ), translation( accuracy ) {
+
+    }
+    // operator+=
+    inline TrajectoryErrors& operator+=(const TrajectoryErrors& other) {
+        rotation += other.rotation;
+        translation += other.translation;
+        return *this;
+    }
+};
+
+// pose_errors, rotation and translation errors of a[i]^-1 b[i] for every pair, in the given form
+template<typename qScalar, typename Scalar1, typename Scalar2>
+inline void pose_errors(const DualQuatBatch<Scalar1>& a, const DualQuatBatch<Scalar2>& b, qScalar* rotation, qScalar* translation,
+                        const MetricForm form=MetricForm::Exact, const std::size_t threads=0) {
+    if (a.size() != b.size()) {
+        throw std::runtime_error("Error: pose_errors() Pose batches differ in size.");
+    }
+    parallel_for(0, a.size(), [&](const std::size_t first, const std::size_t last, std::size_t) {
+        for (std::size_t i=first; i<last; ++i) {
+            qScalar pose_a[8], pose_b[8];
+            a.load(i, pose_a);
+            b.load(i, pose_b);
+            kernel::pose_error_proxy(pose_a, pose_b, rotation[i], translation[i]);
+            kernel::finish_errors(rotation[i], translation[i], form);
+        }
+    }, threads, 16384);
+}
+// motion_errors, errors between the relative motions a[i]^-1 a[i+delta] and b[i]^-1 b[i+delta], returns their number, size - delta
+template<typename qScalar, typename Scalar1, typename Scalar2>
+inline std::size_t motion_errors(const DualQuatBatch<Scalar1>& a, const DualQuatBatch<Scalar2>& b, const std::size_t delta,
+                                 qScalar* rotation, qScalar* translation, const MetricForm form=MetricForm::Exact, const std::size_t threads=0) {
+    if (a.size() != b.size()) {
+        throw std::runtime_error("Error: motion_errors() Pose batches differ in size.");
+    }
+    const std::size_t size = a.size() > delta ? a.size() - delta : 0;
+    parallel_for(0, size, [&](const std::size_t first, const std::size_t last, std::size_t) {
+        for (std::size_t i=first; i<last; ++i) {
+            qScalar a0[8], a1[8], b0[8], b1[8];
+            a.load(i, a0);
+            a.load(i + delta, a1);
+            b.load(i, b0);
+            b.load(i + delta, b1);
+            kernel::motion_error_proxy(a0, a1, b0, b1, rotation[i], translation[i]);
+            kernel::finish_errors(rotation[i], translation[i], form);
+        }
+    }, threads, 16384);
+    return size;
+}
+// absolute_trajectory_error, statistics of the errors of a[i]^-1 b[i], without storing them
+template<QuatScalar qScalar=double, typename Scalar1, typename Scalar2>
+inline TrajectoryErrors<qScalar> absolute_trajectory_error(const DualQuatBatch<Scalar1>& a, const DualQuatBatch<Scalar2>& b,
+                                                           const MetricForm form=MetricForm::Exact, const qScalar accuracy=0.01,
+                                                           const std::size_t threads=0) {
+    if (a.size() != b.size()) {
+        throw std::runtime_error("Error: absolute_trajectory_error() Pose batches differ in size.");
+    }
+    return parallel_reduce(std::size_t(0), a.size(), TrajectoryErrors<qScalar>(accuracy), [&](const std::size_t first, const std::size_t last) {
+        TrajectoryErrors<qScalar> res(accuracy);
+        for (std::size_t i=first; i<last; ++i) {
+            qScalar pose_a[8], pose_b[8], rotation, translation;
+            a.load(i, pose_a);
+            b.load(i, pose_b);
+            kernel::pose_error_proxy(pose_a, pose_b, rotation, translation);
+            kernel::finish_errors(rotation, translation, form);
+            res.rotation.add(rotation);
+            res.translation.add(translation);
+        }
+        return res;
+    }, [](TrajectoryErrors<qScalar> lhs, const TrajectoryErrors<qScalar>& rhs) {
+        return lhs += rhs;
+    }, threads, 16384);
+}
+// relative_pose_error, statistics of the errors between the relative motions over delta, without storing them
+template<QuatScalar qScalar=double, typename Scalar1, typename Scalar2>
+inline TrajectoryErrors<qScalar> relative_pose_error(const DualQuatBatch<Scalar1>& a, const DualQuatBatch<Scalar2>& b, const std::size_t delta=1,
+                                                     const MetricForm form=MetricForm::Exact, const qScalar accuracy=0.01,
+                                                     const std::size_t threads=0) {
+    if (a.size() != b.size()) {
+        throw std::runtime_error("Error: relative_pose_error() Pose batches differ in size.");
+    }
+    const std::size_t size = a.size() > delta ? a.size() - delta : 0;
+    return parallel_reduce(std::size_t(0), size, TrajectoryErrors<qScalar>(accuracy), [&](const std::size_t first, const std::size_t last) {
+        TrajectoryErrors<qScalar> res(accuracy);
+        for (std::size_t i=first; i<last; ++i) {
+            qScalar a0[8], a1[8], b0[8], b1[8], rotation, translation;
+            a.load(i, a0);
+            a.load(i + delta, a1);
+            b.load(i, b0);
+            b.load(i + delta, b1);
+            kernel::motion_error_proxy(a0, a1, b0, b1, rotation, translation);
+            kernel::finish_errors(rotation, translation, form);
+            res.rotation.add(rotation);
+            res.translation.add(translation);
+        }
+        return res;
+    }, [](TrajectoryErrors<qScalar> lhs, const TrajectoryErrors<qScalar>& rhs) {
+        return lhs += rhs;
+    }, threads, 16384);
+}
+
+using ErrorStatisticsf = ErrorStatistics<float>;
+using ErrorStatisticsd = ErrorStatistics<double>;
+using ErrorStatisticsld = ErrorStatistics<long double>;
+using TrajectoryErrorsf = TrajectoryErrors<float>;
+using TrajectoryErrorsd = TrajectoryErrors<double>;
+using TrajectoryErrorsld = TrajectoryErrors<long double>;
+
+}  // namespace dqpose
@@ -0,0 +1,116 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/parallel.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining the threading helpers
+ *
+ *     This file provides parallel_for and parallel_reduce, which split an
+ *     index range into contiguous chunks and run them on std::threads,
+ *     the calling thread taking the first chunk. Threads are created per
+ *     call, so the helpers pay off on large ranges only; ranges shorter
+ *     than min_chunk run inline.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+namespace dqpose
+{
+
+// hardware_threads, at least 1
+inline std::size_t hardware_threads() noexcept {
+    const unsigned int threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+}
+
+// parallel_chunks, number of chunks [first, last) is split into
+inline std::size_t parallel_chunks(const std::size_t first, const std::size_t last, const std::size_t threads, const std::size_t min_chunk) noexcept {
+    const std::size_t size = last > first ? last - first : 0;
+    const std::size_t max_threads = threads == 0 ? hardware_threads() : threads;
+    const std::size_t max_chunks = min_chunk == 0 ? size : (size + min_chunk - 1) / min_chunk;
+    return std::max<std::size_t>(1, std::min(max_threads, max_chunks));
+}
+
+// parallel_for, calls function(chunk_first, chunk_last, chunk) on contiguous chunks of [first, last)
+template<typename Function>
+inline void parallel_for(const std::size_t first, const std::size_t last, Function&& function,
+                         const std::size_t threads=0, const std::size_t min_chunk=1024) {
+    if (last <= first) {
+        return;
+    }
+    const std::size_t chunks = parallel_chunks(first, last, threads, min_chunk);
+    if (chunks == 1) {
+        function(first, last, std::size_t(0));
+        return;
+    }
+    const std::size_t size = last - first;
+    const auto chunk_first = [&](const std::size_t chunk) { return first + size * chunk / chunks; };
+    std::vector<std::exception_ptr> errors(chunks);
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for (std::size_t chunk=1; chunk<chunks; ++chunk) {
+        workers.emplace_back([&, chunk]() {
+            try {
+                function(chunk_first(chunk), chunk_first(chunk + 1), chunk);
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        });
+    }
+    try {
+        function(chunk_first(0), chunk_first(1), std::size_t(0));
+    } catch (...) {
+        errors[0] = std::current_exception();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// parallel_reduce, combines the results of function(chunk_first, chunk_last) in chunk order, init is the identity of combine
+template<typename T, typename Function, typename Combine>
+inline T parallel_reduce(const std::size_t first, const std::size_t last, const T& init, Function&& function, Combine&& combine,
+                         const std::size_t threads=0, const std::size_t min_chunk=1024) {
+    const std::size_t chunks = parallel_chunks(first, last, threads, min_chunk);
+    std::vector<T> partials(chunks, init);
+    parallel_for(first, last, [&](const std::size_t chunk_first, const std::size_t chunk_last, const std::size_t chunk) {
+        partials[chunk] = function(chunk_first, chunk_last);
+    }, threads, min_chunk);
+    T res = init;
+    for (const auto& partial : partials) {
+        res = combine(res, partial);
+    }
+    return res;
+}
+
+}  // namespace dqpose
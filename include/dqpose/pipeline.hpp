@@ -0,0 +1,446 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/pipeline.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining batched pipelines over pose streams
+ *
+ *     This file provides Pipeline, a chain of stages between a source and a
+ *     sink that pass PoseBatches, timestamps and a DualQuatBatch, through
+ *     BoundedQueues. Every stage runs on its own threads, one or more
+ *     workers, so decode, validate, transform, interpolate and encode
+ *     overlap while each call sees a whole batch to vectorize over. Queues
+ *     lock once per batch, not per pose, and batches are recycled from the
+ *     sink back to the source, so a running pipeline allocates nothing once
+ *     the batches reached their largest size.
+ *
+ *     Stages with a single worker and the sink take the batches in source
+ *     order, even after stages with several workers, unless ordering is
+ *     turned off, so stateful stages such as resampling stay correct. The first exception of any
+ *     stage stops the pipeline and is rethrown by run. Ready made stages
+ *     cover the usual steps: reading and writing logs of stream.hpp,
+ *     dropping non unit poses, normalizing, applying a frame and resampling
+ *     at a fixed period by the screw motion between neighbours.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "stream.hpp"
+#include "trace_macros.hpp"
+#include <array>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace dqpose
+{
+
+struct PipelineOptions {
+    // batches waiting between two stages
+    std::size_t queue_capacity = 4;
+    // batches in the pipeline, recycled from the sink back to the source
+    std::size_t pool_size = 16;
+    // hand the batches to single worker stages and to the sink in source order, even after stages with several workers
+    bool ordered = true;
+};
+
+// PipelineReport, seconds are wall time, stage seconds the time spent in the stage functions summed over workers
+struct PipelineReport {
+    std::uint64_t batches = 0;
+    std::uint64_t poses = 0;
+    double seconds = 0;
+    std::vector<std::pair<std::string, double>> stage_seconds;
+};
+
+template<QuatScalar qScalar>
+struct PoseBatch {
+    // position in the source order
+    std::uint64_t sequence = 0;
+    std::vector<double> timestamps;
+    DualQuatBatch<qScalar> poses;
+
+    inline std::size_t size() const noexcept { return timestamps.size(); }
+    inline void resize(const std::size_t size) {
+        timestamps.resize(size);
+        poses.resize(size);
+    }
+    inline void clear() { resize(0); }
+};
+
+template<typename T>
+class BoundedQueue {
+protected:
+    std::mutex _mutex;
+    std::condition_variable _not_empty;
+    std::condition_variable _not_full;
+    std::deque<T> _items;
+    std::size_t _capacity;
+    bool _closed = false;
+public:
+    // Capacity Constructor
+    explicit BoundedQueue(const std::size_t capacity)
+        : _capacity( capacity ) {
+        if (capacity == 0) {
+            throw std::runtime_error("Error: BoundedQueue() Capacity must be positive.");
+        }
+    }
+    // push, waits for room, false once closed
+    inline bool push(T item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [&]{ return _closed || _items.size() < _capacity; });
+        if (_closed) return false;
+        _items.push_back(std::move(item));
+        lock.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+    // pop, waits for an item, false once closed and drained
+    inline bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_empty.wait(lock, [&]{ return _closed || !_items.empty(); });
+        if (_items.empty()) return false;
+        item = std::move(_items.front());
+        _items.pop_front();
+        lock.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+    // close, wakes every waiting thread, items already queued can still be popped
+    inline void close() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+        }
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+    // abort, closes and drops the queued items
+    inline void abort() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closed = true;
+            _items.clear();
+        }
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+};
+
+template<QuatScalar qScalar>
+class Pipeline {
+public:
+    using Batch = PoseBatch<qScalar>;
+    // Source, fills a cleared batch, false at the end of the stream
+    using Source = std::function<bool(Batch&)>;
+    // Stage, edits a batch in place, it may change its size
+    using Stage = std::function<void(Batch&)>;
+    // Sink, consumes a batch
+    using Sink = std::function<void(const Batch&)>;
+protected:
+    struct _Stage {
+        std::string name;
+        Stage function;
+        std::size_t workers;
+    };
+    using _Queue = BoundedQueue<std::unique_ptr<Batch>>;
+    // _Reorder, pops the batches of a queue in sequence order, holding the early ones
+    struct _Reorder {
+        std::map<std::uint64_t, std::unique_ptr<Batch>> early;
+        std::uint64_t expected = 0;
+
+        inline bool pop(_Queue& queue, std::unique_ptr<Batch>& batch) {
+            for (;;) {
+                const auto it = early.find(expected);
+                if (it != early.end()) {
+                    batch = std::move(it->second);
+                    early.erase(it);
+                    ++expected;
+                    return true;
+                }
+                if (!queue.pop(batch)) return false;
+                if (batch->sequence == expected) {
+                    ++expected;
+                    return true;
+                }
+                early.emplace(batch->sequence, std::move(batch));
+            }
+        }
+    };
+    PipelineOptions _options;
+    std::vector<_Stage> _stages;
+public:
+    // Options Constructor
+    explicit Pipeline(const PipelineOptions& options=PipelineOptions())
+        : _options( options ) {
+        if (options.pool_size == 0) {
+            throw std::runtime_error("Error: Pipeline() Pool size must be positive.");
+        }
+    }
+    // then, appends a stage run by workers threads, a stateful stage needs a single worker
+    inline Pipeline& then(std::string name, Stage function, const std::size_t workers=1) {
+        if (workers == 0) {
+            throw std::runtime_error("Error: Pipeline::then() A stage needs at least one worker.");
+        }
+        _stages.push_back({ std::move(name), std::move(function), workers });
+        return *this;
+    }
+    // stages
+    inline std::size_t stages() const noexcept { return _stages.size(); }
+    // run, streams the source through every stage into the sink, the sink runs on the calling thread
+    inline PipelineReport run(const Source& source, const Sink& sink) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::size_t count = _stages.size();
+        _Queue pool(_options.pool_size);
+        std::vector<std::unique_ptr<_Queue>> queues;
+        for (std::size_t s=0; s<=count; ++s) queues.push_back(std::make_unique<_Queue>(_options.queue_capacity));
+        for (std::size_t b=0; b<_options.pool_size; ++b) pool.push(std::make_unique<Batch>());
+
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        const auto fail = [&](std::exception_ptr e) {
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = e;
+            }
+            pool.abort();
+            for (auto& queue : queues) queue->abort();
+        };
+        std::vector<std::atomic<std::size_t>> active(count);
+        std::vector<std::atomic<std::int64_t>> busy(count);
+        std::vector<std::uint32_t> operations(count);
+        for (std::size_t s=0; s<count; ++s) {
+            active[s] = _stages[s].workers;
+            busy[s] = 0;
+#ifdef DQPOSE_TRACE
+            operations[s] = trace::operation(("dqpose::Pipeline::" + _stages[s].name).c_str());
+#endif
+        }
+
+        std::vector<std::thread> threads;
+        // source, sequences the batches
+        threads.emplace_back([&]() {
+            try {
+                std::unique_ptr<Batch> batch;
+                for (std::uint64_t sequence=0; pool.pop(batch); ++sequence) {
+                    batch->clear();
+                    batch->sequence = sequence;
+                    if (!source(*batch) || !queues[0]->push(std::move(batch))) break;
+                }
+                queues[0]->close();
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        });
+        for (std::size_t s=0; s<count; ++s) {
+            for (std::size_t w=0; w<_stages[s].workers; ++w) {
+                threads.emplace_back([&, s]() {
+                    try {
+                        // a single worker takes its batches in source order, as a stateful stage expects
+                        const bool ordered = _options.ordered && _stages[s].workers == 1;
+                        _Reorder reorder;
+                        std::unique_ptr<Batch> batch;
+                        while (ordered ? reorder.pop(*queues[s], batch) : queues[s]->pop(batch)) {
+                            const auto begin = std::chrono::steady_clock::now();
+                            {
+#ifdef DQPOSE_TRACE
+                                const trace::Scope scope(operations[s]);
+#endif
+                                _stages[s].function(*batch);
+                            }
+                            busy[s] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+                            if (!queues[s+1]->push(std::move(batch))) break;
+                        }
+                        // the last worker of a stage ends the next one
+                        if (--active[s] == 0) queues[s+1]->close();
+                    } catch (...) {
+                        fail(std::current_exception());
+                    }
+                });
+            }
+        }
+
+        PipelineReport report;
+        try {
+            _Reorder reorder;
+            std::unique_ptr<Batch> batch;
+            while (_options.ordered ? reorder.pop(*queues[count], batch) : queues[count]->pop(batch)) {
+                sink(*batch);
+                ++report.batches;
+                report.poses += batch->size();
+                pool.push(std::move(batch));
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        for (auto& thread : threads) thread.join();
+        if (error) std::rethrow_exception(error);
+
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (std::size_t s=0; s<count; ++s) report.stage_seconds.emplace_back(_stages[s].name, static_cast<double>(busy[s]) * 1e-9);
+        return report;
+    }
+};
+
+// reader_source, batches of up to batch_size records of a log
+template<QuatScalar qScalar>
+inline typename Pipeline<qScalar>::Source reader_source(PoseReader<qScalar>& reader, const std::size_t batch_size) {
+    return [&reader, batch_size](PoseBatch<qScalar>& batch) {
+        return reader.read(batch.timestamps, batch.poses, batch_size) != 0;
+    };
+}
+
+// writer_sink, appends every batch to a log
+template<QuatScalar qScalar>
+inline typename Pipeline<qScalar>::Sink writer_sink(PoseWriter<qScalar>& writer) {
+    return [&writer](const PoseBatch<qScalar>& batch) {
+        writer.write(batch.timestamps.data(), batch.poses);
+    };
+}
+
+// validate_stage, drops the poses that are not unit within the squared tolerance or not finite, see unit_mask
+template<QuatScalar qScalar, typename cScalar=std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>>
+inline typename Pipeline<qScalar>::Stage validate_stage(const cScalar tolerance=64*std::numeric_limits<cScalar>::epsilon()) {
+    return [tolerance](PoseBatch<qScalar>& batch) {
+        std::vector<std::uint8_t> mask(batch.size());
+        if (unit_mask(batch.poses, mask.data(), tolerance) == batch.size()) return;
+        std::size_t kept = 0;
+        for (std::size_t i=0; i<batch.size(); ++i) {
+            if (!mask[i]) continue;
+            if (kept != i) {
+                qScalar dq[8];
+                batch.poses.load(i, dq);
+                batch.poses.store(kept, dq);
+                batch.timestamps[kept] = batch.timestamps[i];
+            }
+            ++kept;
+        }
+        batch.resize(kept);
+    };
+}
+
+// normalize_stage, see normalize
+template<QuatScalar qScalar>
+inline typename Pipeline<qScalar>::Stage normalize_stage(const NormalizeMethod method=NormalizeMethod::NearUnit) {
+    return [method](PoseBatch<qScalar>& batch) {
+        normalize(batch.poses, method);
+    };
+}
+
+// frame_stage, expresses every pose in another frame, pose = frame * pose
+template<QuatScalar qScalar, typename Scalar>
+inline typename Pipeline<qScalar>::Stage frame_stage(const DualQuat<Scalar>& frame) {
+    using cScalar = std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>;
+    const auto frame8 = frame.array();
+    std::array<cScalar, 8> arr;
+    for (int k=0; k<8; ++k) arr[k] = static_cast<cScalar>(frame8[k]);
+    return [arr](PoseBatch<qScalar>& batch) {
+        for (std::size_t i=0; i<batch.size(); ++i) {
+            cScalar dq[8];
+            batch.poses.load(i, dq);
+            kernel::dualquat_mul(arr.data(), dq, dq);
+            batch.poses.store(i, dq);
+        }
+    };
+}
+
+// resample_stage, replaces the poses by samples at every multiple of the period, each the screw motion interpolation
+// a exp(s log(a* b)) of its neighbours a and b along the shorter rotation; it carries the last pose over to the next
+// batch, so it needs a single worker, timestamps must increase
+template<QuatScalar qScalar>
+inline typename Pipeline<qScalar>::Stage resample_stage(const double period) {
+    using cScalar = std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>;
+    if (!(period > 0)) {
+        throw std::runtime_error("Error: resample_stage() Period must be positive.");
+    }
+    struct State {
+        bool started = false;
+        double last_time = 0;
+        // the next sample is at next * period, a count so that long streams do not drift
+        double next = 0;
+        cScalar last[8];
+        std::vector<double> timestamps;
+        DualQuatBatch<qScalar> poses;
+    };
+    return [period, state = std::make_shared<State>()](PoseBatch<qScalar>& batch) {
+        State& st = *state;
+        st.timestamps.clear();
+        st.poses.clear();
+        const auto emit = [&](const double time, const cScalar* dq) {
+            st.timestamps.push_back(time);
+            st.poses.resize(st.timestamps.size());
+            st.poses.store(st.timestamps.size() - 1, dq);
+        };
+        for (std::size_t i=0; i<batch.size(); ++i) {
+            const double time = batch.timestamps[i];
+            cScalar current[8];
+            batch.poses.load(i, current);
+            if (!st.started) {
+                st.started = true;
+                st.next = std::ceil(time / period);
+            } else if (!(time > st.last_time)) {
+                throw std::runtime_error("Error: resample_stage() Timestamps must increase.");
+            } else if (st.next * period < time) {
+                const double span = time - st.last_time;
+                for (; st.next * period < time; ++st.next) {
+                    const cScalar s = static_cast<cScalar>((st.next * period - st.last_time) / span);
+                    cScalar sample[8];
+                    kernel::unit_dualquat_interpolate(st.last, current, s, sample);
+                    emit(st.next * period, sample);
+                }
+            }
+            if (st.next * period == time) {
+                emit(time, current);
+                ++st.next;
+            }
+            st.last_time = time;
+            std::copy(current, current + 8, st.last);
+        }
+        std::swap(batch.timestamps, st.timestamps);
+        std::swap(batch.poses, st.poses);
+    };
+}
+
+using PoseBatchf = PoseBatch<float>;
+using PoseBatchd = PoseBatch<double>;
+using PoseBatchld = PoseBatch<long double>;
+using Pipelinef = Pipeline<float>;
+using Pipelined = Pipeline<double>;
+using Pipelineld = Pipeline<long double>;
+
+}  // namespace dqpose
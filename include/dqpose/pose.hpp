@@ -33,24 +33,26 @@
 
 #include "quat.hpp"
 #include "dualquat.hpp"
+#include "kernel.hpp"
 #include <cstdint>
 
 namespace dqpose
 {
 
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class Rotation;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class Translation;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class UnitAxis;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class Pose;
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class Rotation : public UnitQuat<qScalar> 
 {
 public:
+using Mat33 = std::array<std::array<qScalar, 3>, 3>;
     // Default Constructor 
     constexpr explicit Rotation() noexcept
         : UnitQuat<qScalar>() {
@@ -60,6 +62,11 @@ public:
     constexpr explicit Rotation(const qScalar w, const qScalar x=0, const qScalar y=0, const qScalar z=0) noexcept
         : UnitQuat<qScalar>( w, x, y, z ) {
 
+    }
+    // Unnormalized Scalar Constructor, the components must already be unit
+    constexpr explicit Rotation(Unnormalized tag, const qScalar w, const qScalar x, const qScalar y, const qScalar z) noexcept
+        : UnitQuat<qScalar>( tag, w, x, y, z ) {
+
     }
     // Axis-Angle Constructor 
     template<typename Scalar>
@@ -103,6 +110,34 @@ public:
     constexpr inline qScalar rotation_angle() const noexcept {
         return 2 * acos(this->w() / this->norm());
     }
+    // to_matrix
+    constexpr inline Mat33 to_matrix() const noexcept {
+        qScalar m[9];
+        kernel::quat_to_matrix(this->data(), m, 3, 1);
+        return Mat33{{ { m[0], m[1], m[2] }, { m[3], m[4], m[5] }, { m[6], m[7], m[8] } }};
+    }
+    // to_matrix, writes into a caller buffer of 9 scalars
+    template<typename Scalar>
+    constexpr inline void to_matrix(Scalar* mat, const MatrixLayout layout=MatrixLayout::RowMajor) const noexcept {
+        std::size_t row_stride, col_stride;
+        kernel::matrix_strides(layout, 3, row_stride, col_stride);
+        kernel::quat_to_matrix(this->data(), mat, row_stride, col_stride);
+    }
+    // from_matrix
+    template<typename Scalar>
+    constexpr static Rotation from_matrix(const std::array<std::array<Scalar, 3>, 3>& mat) noexcept {
+        const Scalar m[9] = { mat[0][0], mat[0][1], mat[0][2], mat[1][0], mat[1][1], mat[1][2], mat[2][0], mat[2][1], mat[2][2] };
+        return from_matrix(m);
+    }
+    // from_matrix, reads from a caller buffer of 9 scalars
+    template<typename Scalar>
+    constexpr static Rotation from_matrix(const Scalar* mat, const MatrixLayout layout=MatrixLayout::RowMajor) noexcept {
+        std::size_t row_stride, col_stride;
+        kernel::matrix_strides(layout, 3, row_stride, col_stride);
+        qScalar q[4];
+        kernel::matrix_to_quat(mat, q, row_stride, col_stride);
+        return Rotation(q[0], q[1], q[2], q[3]);
+    }
 
     // Default
         virtual ~Rotation()=default;
@@ -112,7 +147,7 @@ public:
     Rotation& operator=(Rotation&&)=default;
 };
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class Translation : public PureQuat<qScalar> {
 public:
     // Default Constructor
@@ -145,24 +180,24 @@ public:
     // active_rotate 
     template<typename Scalar>
     constexpr inline Translation& active_rotate(const Rotation<Scalar>& rotation) noexcept {
-        PureQuat<qScalar>::operator=(rotation * *this * rotation.conj());
+        kernel::quat_rotate(rotation.data(), this->data() + 1, this->_data.data() + 1);
         return *this;
     }
     // passive_rotate 
     template<typename Scalar>
     constexpr inline Translation& passive_rotate(const Rotation<Scalar>& rotation) noexcept {
-        PureQuat<qScalar>::operator=(rotation.conj() * *this * rotation);
+        kernel::quat_inverse_rotate(rotation.data(), this->data() + 1, this->_data.data() + 1);
         return *this;
     }
     // active_rotated
     template<typename Scalar>
     constexpr inline Translation active_rotated(const Rotation<Scalar>& rotation) const noexcept {
-        return Translation(rotation * *this * rotation.conj());
+        return Translation(*this).active_rotate(rotation);
     }    
     // passive_rotated
     template<typename Scalar>
     constexpr inline Translation passive_rotated(const Rotation<Scalar>& rotation) const noexcept {
-        return Translation(rotation.conj() * *this * rotation);
+        return Translation(*this).passive_rotate(rotation);
     }
     // perpendicular
     template<typename Scalar>
@@ -185,7 +220,7 @@ public:
     Translation& operator=(Translation&&)=default;
 };   
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class UnitAxis : public UnitPureQuat<qScalar> {
 public:
     // Scalar Constructor
@@ -213,24 +248,26 @@ public:
     // active_rotate 
     template<typename Scalar>
     constexpr inline UnitAxis& active_rotate(const Rotation<Scalar>& rotation) noexcept {
-        UnitPureQuat<qScalar>::operator=(rotation * *this * rotation.conj());
+        kernel::quat_rotate(rotation.data(), this->data() + 1, this->_data.data() + 1);
+        this->normalize();
         return *this;
     }
     // passive_rotate 
     template<typename Scalar>
     constexpr inline UnitAxis& passive_rotate(const Rotation<Scalar>& rotation) noexcept {
-        UnitPureQuat<qScalar>::operator=(rotation.conj() * *this * rotation);
+        kernel::quat_inverse_rotate(rotation.data(), this->data() + 1, this->_data.data() + 1);
+        this->normalize();
         return *this;
     }
     // active_rotated
     template<typename Scalar>
     constexpr inline UnitAxis active_rotated(const Rotation<Scalar>& rotation) const noexcept {
-        return UnitAxis(rotation * *this * rotation.conj());
+        return UnitAxis(*this).active_rotate(rotation);
     }    
     // passive_rotated
     template<typename Scalar>
     constexpr inline UnitAxis passive_rotated(const Rotation<Scalar>& rotation) const noexcept {
-        return UnitAxis(rotation.conj() * *this * rotation);
+        return UnitAxis(*this).passive_rotate(rotation);
     }
     // perpendicular
     template<typename Scalar>
@@ -261,9 +298,10 @@ public:
     UnitAxis& operator=(UnitAxis&&)=default;
 };    
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class Pose : public UnitDualQuat<qScalar> {
 public:
+using Mat44 = std::array<std::array<qScalar, 4>, 4>;
     // Default Constructor 
     constexpr explicit Pose() noexcept
         : UnitDualQuat<qScalar>() {
@@ -274,6 +312,12 @@ public:
                       const qScalar w2=0, const qScalar x2=0, const qScalar y2=0, const qScalar z2=0) noexcept
         : UnitDualQuat<qScalar>( w1, x1, y1, z1, w2, x2, y2, z2 ) {
 
+    }
+    // Unnormalized Scalar Constructor, the components must already be unit
+    constexpr explicit Pose(Unnormalized tag, const qScalar w1, const qScalar x1, const qScalar y1, const qScalar z1,
+                            const qScalar w2, const qScalar x2, const qScalar y2, const qScalar z2) noexcept
+        : UnitDualQuat<qScalar>( tag, w1, x1, y1, z1, w2, x2, y2, z2 ) {
+
     }
     // Rotation-Translation Constructor 
     template<typename Scalar1, typename Scalar2>
@@ -310,7 +354,42 @@ public:
     }
 
     constexpr Rotation<qScalar> rotation() const noexcept { return Rotation<qScalar>(this->real()); }
-    constexpr Translation<qScalar> translation() const noexcept { return Translation<qScalar>(this->dual() * this->real().conj() * 2); }
+    constexpr Translation<qScalar> translation() const noexcept { 
+        qScalar t3[3];
+        kernel::dualquat_translation(this->array().data(), t3);
+        return Translation<qScalar>(t3[0], t3[1], t3[2]); 
+    }
+    // to_matrix
+    constexpr inline Mat44 to_matrix() const noexcept {
+        qScalar m[16];
+        to_matrix(m);
+        return Mat44{{ { m[0], m[1], m[2], m[3] }, { m[4], m[5], m[6], m[7] }, { m[8], m[9], m[10], m[11] }, { m[12], m[13], m[14], m[15] } }};
+    }
+    // to_matrix, writes into a caller buffer of 16 scalars
+    template<typename Scalar>
+    constexpr inline void to_matrix(Scalar* mat, const MatrixLayout layout=MatrixLayout::RowMajor) const noexcept {
+        std::size_t row_stride, col_stride;
+        kernel::matrix_strides(layout, 4, row_stride, col_stride);
+        kernel::dualquat_to_matrix(this->array().data(), mat, row_stride, col_stride);
+    }
+    // from_matrix
+    template<typename Scalar>
+    constexpr static Pose from_matrix(const std::array<std::array<Scalar, 4>, 4>& mat) noexcept {
+        Scalar m[16];
+        for (int i=0; i<4; ++i) {
+            std::copy(mat[i].begin(), mat[i].end(), m + 4*i);
+        }
+        return from_matrix(m);
+    }
+    // from_matrix, reads from a caller buffer of 16 scalars
+    template<typename Scalar>
+    constexpr static Pose from_matrix(const Scalar* mat, const MatrixLayout layout=MatrixLayout::RowMajor) noexcept {
+        std::size_t row_stride, col_stride;
+        kernel::matrix_strides(layout, 4, row_stride, col_stride);
+        std::array<qScalar, 8> dq;
+        kernel::matrix_to_dualquat(mat, dq.data(), row_stride, col_stride);
+        return Pose(DualQuat<qScalar>(dq));
+    }
 
     template<typename First_, typename... Args_>
     constexpr static Pose build_from(const First_& first, const Args_&... args){
@@ -348,9 +427,30 @@ using Rotld = Rotation<long double>;
 using Tranld = Translation<long double>;
 using Unitld = UnitAxis<long double>;
 using Poseld = Pose<long double>;
+using Roth = Rotation<Half>;
+using Tranh = Translation<Half>;
+using Unith = UnitAxis<Half>;
+using Poseh = Pose<Half>;
+using Rotbf = Rotation<BFloat16>;
+using Tranbf = Translation<BFloat16>;
+using Unitbf = UnitAxis<BFloat16>;
+using Posebf = Pose<BFloat16>;
 
 constexpr UnitAxis<std::uint8_t> i_(1,0,0);
 constexpr UnitAxis<std::uint8_t> j_(0,1,0);
 constexpr UnitAxis<std::uint8_t> k_(0,0,1);
 
+#ifdef DQPOSE_USE_LIBRARY
+// instantiated once in the dqpose library, see src/dqpose.cpp
+#define DQPOSE_EXTERN_POSE(Scalar) \
+    extern template class Rotation<Scalar>; \
+    extern template class Translation<Scalar>; \
+    extern template class UnitAxis<Scalar>; \
+    extern template class Pose<Scalar>;
+DQPOSE_EXTERN_POSE(float)
+DQPOSE_EXTERN_POSE(double)
+DQPOSE_EXTERN_POSE(long double)
+#undef DQPOSE_EXTERN_POSE
+#endif
+
 }  // namespace dqpose
@@ -0,0 +1,532 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/posegraph.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining pose graph optimization
+ *
+ *     This file provides PoseGraph, whose nodes are Poses and whose edges
+ *     are relative Pose measurements weighted by 6x6 information matrices.
+ *     The residual of an edge is the log of measurement^-1 from^-1 to,
+ *     taken as the 6 vector parts of DualQuat::log, and nodes are updated
+ *     on the right, node * exp(delta).
+ *
+ *     optimize() runs Levenberg-Marquardt. Each normal equation is solved
+ *     either by a sparse block Cholesky factorization under a minimum
+ *     degree ordering, the default, or matrix-free by conjugate gradients
+ *     preconditioned with the inverse diagonal blocks, which needs no fill
+ *     but converges slowly on long chains. Residuals and Jacobians run on
+ *     parallel_for, the conjugate gradient iterations in a single parallel
+ *     region whose threads meet at a barrier between steps.
+ *     Edge Jacobians are cached and recomputed only once an end node has
+ *     moved more than relinearize_threshold since, so repeated calls after
+ *     adding nodes and edges mostly touch the new part of the graph.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "kernel.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include <vector>
+#include <limits>
+#include <barrier>
+#include <algorithm>
+
+namespace dqpose
+{
+
+enum class PoseGraphSolver { SparseCholesky, ConjugateGradient };
+
+template<typename qScalar>
+class PoseGraphOptions {
+public:
+    // Levenberg-Marquardt iterations, rejected steps included
+    std::size_t max_iterations = 50;
+    // stop once the relative error decrease falls below
+    qScalar tolerance = qScalar(1e-10);
+    // initial damping, 0 gives Gauss-Newton
+    qScalar lambda = qScalar(1e-5);
+    // linear solver of the normal equations
+    PoseGraphSolver solver = PoseGraphSolver::SparseCholesky;
+    // conjugate gradient iterations per step and relative residual to reach
+    std::size_t max_cg_iterations = 500;
+    qScalar cg_tolerance = qScalar(1e-8);
+    // update norm a node may accumulate before its edges are relinearized, 0 relinearizes every move
+    qScalar relinearize_threshold = 0;
+    // worker threads, 0 uses every hardware thread
+    std::size_t threads = 0;
+};
+
+template<typename qScalar>
+class PoseGraphReport {
+public:
+    qScalar initial_error = 0;
+    qScalar final_error = 0;
+    std::size_t iterations = 0;
+    std::size_t cg_iterations = 0;
+    std::size_t relinearized_edges = 0;
+};
+
+template<QuatScalar qScalar>
+class PoseGraph {
+public:
+using Vec6 = std::array<qScalar, 6>;
+using Mat66 = std::array<qScalar, 36>;
+using Arr8 = std::array<qScalar, 8>;
+
+class Edge {
+public:
+    std::size_t from;
+    std::size_t to;
+    Pose<qScalar> measurement;
+    Mat66 information;
+};
+
+protected:
+    std::vector<Pose<qScalar>> _nodes;
+    std::vector<std::uint8_t> _fixed;
+    std::vector<Edge> _edges;
+    // linearization cache, per edge
+    std::vector<Mat66> _jacobian_from;
+    std::vector<Mat66> _jacobian_to;
+    std::vector<std::uint8_t> _linearized;
+    // update norm accumulated by every node since its edges were relinearized
+    std::vector<qScalar> _drift;
+
+    // identity
+    constexpr static Mat66 _identity() noexcept {
+        Mat66 res{};
+        for (int i=0; i<6; ++i) res[i*6 + i] = 1;
+        return res;
+    }
+    // _residual, tangent of measurement* from* to, on the positive real hemisphere
+    constexpr static void _residual(const qScalar* from, const qScalar* to, const qScalar* measurement_conj, qScalar* r6) noexcept {
+        qScalar error[8];
+        kernel::dualquat_conj(from, error);
+        kernel::dualquat_mul(measurement_conj, error, error);
+        kernel::dualquat_mul(error, to, error);
+        if (error[0] < 0) {
+            for (int i=0; i<8; ++i) error[i] = -error[i];
+        }
+        kernel::dualquat_tangent(error, r6);
+    }
+    // _retract, node * exp(delta)
+    constexpr static void _retract(const qScalar* node, const qScalar* delta, qScalar* out) noexcept {
+        qScalar step[8];
+        kernel::dualquat_from_tangent(delta, step);
+        kernel::dualquat_mul(node, step, out);
+    }
+    // _linearize, central difference Jacobians of the residual w.r.t. right updates of both nodes
+    constexpr static void _linearize(const qScalar* from, const qScalar* to, const qScalar* measurement_conj,
+                                     Mat66& jacobian_from, Mat66& jacobian_to) noexcept {
+        const qScalar step = std::sqrt(std::sqrt(std::numeric_limits<qScalar>::epsilon())) * qScalar(0.1);
+        qScalar perturbed[8], from_plus[6], from_minus[6], to_plus[6], to_minus[6];
+        for (int k=0; k<6; ++k) {
+            qScalar delta[6] = { 0, 0, 0, 0, 0, 0 };
+            delta[k] = step;
+            _retract(from, delta, perturbed);
+            _residual(perturbed, to, measurement_conj, from_plus);
+            _retract(to, delta, perturbed);
+            _residual(from, perturbed, measurement_conj, to_plus);
+            delta[k] = -step;
+            _retract(from, delta, perturbed);
+            _residual(perturbed, to, measurement_conj, from_minus);
+            _retract(to, delta, perturbed);
+            _residual(from, perturbed, measurement_conj, to_minus);
+            for (int i=0; i<6; ++i) {
+                jacobian_from[i*6 + k] = (from_plus[i] - from_minus[i]) / (2 * step);
+                jacobian_to[i*6 + k] = (to_plus[i] - to_minus[i]) / (2 * step);
+            }
+        }
+    }
+    // _chi2, r^T W r
+    constexpr static qScalar _chi2(const qScalar* r6, const Mat66& information) noexcept {
+        qScalar wr[6];
+        linalg::mul<6, 6>(information, r6, wr);
+        qScalar res = 0;
+        for (int i=0; i<6; ++i) res += r6[i] * wr[i];
+        return res;
+    }
+    // _total_error, 0.5 sum of chi2 over every edge for the given node states
+    inline qScalar _total_error(const std::vector<Arr8>& states, const std::vector<Arr8>& measurements_conj, const std::size_t threads) const {
+        return parallel_reduce(std::size_t(0), _edges.size(), qScalar(0), [&](const std::size_t first, const std::size_t last) {
+            qScalar sum = 0;
+            qScalar r6[6];
+            for (std::size_t e=first; e<last; ++e) {
+                _residual(states[_edges[e].from].data(), states[_edges[e].to].data(), measurements_conj[e].data(), r6);
+                sum += _chi2(r6, _edges[e].information);
+            }
+            return sum;
+        }, [](const qScalar a, const qScalar b) { return a + b; }, threads, 256) / 2;
+    }
+public:
+    // Default Constructor
+    explicit PoseGraph() noexcept
+        : _nodes{ }, _fixed{ }, _edges{ }, _jacobian_from{ }, _jacobian_to{ }, _linearized{ }, _drift{ } {
+
+    }
+    // add_node, returns the index of the new node
+    template<typename Scalar>
+    inline std::size_t add_node(const Pose<Scalar>& pose, const bool fixed=false) {
+        _nodes.emplace_back(pose);
+        _fixed.push_back(fixed);
+        _drift.push_back(0);
+        return _nodes.size() - 1;
+    }
+    // add_edge, measurement is the pose of node to seen from node from, returns the index of the new edge
+    template<typename Scalar>
+    inline std::size_t add_edge(const std::size_t from, const std::size_t to, const Pose<Scalar>& measurement,
+                                const Mat66& information=_identity()) {
+        if (from >= _nodes.size() || to >= _nodes.size() || from == to) {
+            throw std::runtime_error("Error: PoseGraph::add_edge() Invalid node index.");
+        }
+        _edges.push_back(Edge{ from, to, Pose<qScalar>(measurement), information });
+        _jacobian_from.emplace_back();
+        _jacobian_to.emplace_back();
+        _linearized.push_back(false);
+        return _edges.size() - 1;
+    }
+    // fix, a fixed node is never updated
+    inline void fix(const std::size_t node, const bool fixed=true) { _fixed.at(node) = fixed; }
+    // query
+    inline std::size_t node_count() const noexcept { return _nodes.size(); }
+    inline std::size_t edge_count() const noexcept { return _edges.size(); }
+    inline const Pose<qScalar>& node(const std::size_t i) const { return _nodes.at(i); }
+    inline const Edge& edge(const std::size_t i) const { return _edges.at(i); }
+    inline bool fixed(const std::size_t i) const { return _fixed.at(i); }
+    // set_node, the cached Jacobians of its edges are dropped
+    template<typename Scalar>
+    inline void set_node(const std::size_t i, const Pose<Scalar>& pose) {
+        _nodes.at(i) = Pose<qScalar>(pose);
+        _drift[i] = std::numeric_limits<qScalar>::infinity();
+    }
+    // residual, of edge e at the current node estimates
+    inline Vec6 residual(const std::size_t e) const {
+        const Edge& edge = _edges.at(e);
+        const Arr8 measurement_conj = edge.measurement.conj().array();
+        Vec6 res;
+        _residual(_nodes[edge.from].array().data(), _nodes[edge.to].array().data(), measurement_conj.data(), res.data());
+        return res;
+    }
+    // error, 0.5 sum of r^T W r at the current node estimates
+    inline qScalar error(const std::size_t threads=0) const {
+        std::vector<Arr8> states(_nodes.size()), measurements_conj(_edges.size());
+        for (std::size_t i=0; i<_nodes.size(); ++i) states[i] = _nodes[i].array();
+        for (std::size_t e=0; e<_edges.size(); ++e) measurements_conj[e] = _edges[e].measurement.conj().array();
+        return _total_error(states, measurements_conj, threads);
+    }
+    // optimize
+    inline PoseGraphReport<qScalar> optimize(const PoseGraphOptions<qScalar>& options=PoseGraphOptions<qScalar>()) {
+        PoseGraphReport<qScalar> report;
+        const std::size_t node_count = _nodes.size();
+        const std::size_t edge_count = _edges.size();
+        const std::size_t threads = options.threads;
+        if (edge_count == 0) {
+            return report;
+        }
+        // the gauge is held by the first node unless some node is fixed
+        std::vector<std::uint8_t> fixed = _fixed;
+        if (std::find(fixed.begin(), fixed.end(), std::uint8_t(1)) == fixed.end()) {
+            fixed[0] = true;
+        }
+        // node states and conjugated measurements as bare scalars
+        std::vector<Arr8> states(node_count), candidates(node_count), measurements_conj(edge_count);
+        for (std::size_t i=0; i<node_count; ++i) states[i] = _nodes[i].array();
+        for (std::size_t e=0; e<edge_count; ++e) measurements_conj[e] = _edges[e].measurement.conj().array();
+        // incident edges of every node, compressed
+        std::vector<std::size_t> incident_offset(node_count + 1, 0), incident(2 * edge_count);
+        for (const Edge& edge : _edges) {
+            ++incident_offset[edge.from + 1];
+            ++incident_offset[edge.to + 1];
+        }
+        for (std::size_t i=0; i<node_count; ++i) incident_offset[i+1] += incident_offset[i];
+        {
+            std::vector<std::size_t> cursor(incident_offset.begin(), incident_offset.end() - 1);
+            for (std::size_t e=0; e<edge_count; ++e) {
+                incident[cursor[_edges[e].from]++] = e;
+                incident[cursor[_edges[e].to]++] = e;
+            }
+        }
+        // per edge weighted residuals W r and products W J x, per node gradient, diagonal blocks and their factors
+        std::vector<Vec6> weighted_residual(edge_count), weighted_product(edge_count);
+        std::vector<Vec6> gradient(node_count), delta(node_count), cg_r(node_count), cg_z(node_count), cg_p(node_count), cg_q(node_count);
+        std::vector<Mat66> diagonal(node_count), preconditioner(node_count), off_diagonal;
+        std::vector<std::uint8_t> relinearize(node_count);
+        // the sparse factorization works on the free nodes only, its pattern is fixed for the whole call
+        const bool sparse = options.solver == PoseGraphSolver::SparseCholesky;
+        linalg::BlockCholesky<6, qScalar> factorization;
+        std::vector<std::size_t> variable(node_count, 0);
+        std::vector<qScalar> rhs;
+        if (sparse) {
+            std::size_t variable_count = 0;
+            for (std::size_t i=0; i<node_count; ++i) {
+                if (!fixed[i]) variable[i] = variable_count++;
+            }
+            std::vector<std::pair<std::size_t, std::size_t>> pairs;
+            pairs.reserve(edge_count);
+            for (const Edge& edge : _edges) {
+                if (!fixed[edge.from] && !fixed[edge.to]) pairs.emplace_back(variable[edge.from], variable[edge.to]);
+            }
+            factorization.analyze(variable_count, pairs);
+            off_diagonal.resize(edge_count);
+            rhs.resize(6 * variable_count);
+        }
+
+        qScalar lambda = options.lambda;
+        qScalar current_error = _total_error(states, measurements_conj, threads);
+        report.initial_error = current_error;
+        bool linearization_valid = false;
+        while (report.iterations < options.max_iterations) {
+            ++report.iterations;
+            if (!linearization_valid) {
+                // relinearize the edges touching a node that drifted too far, refresh every residual
+                for (std::size_t i=0; i<node_count; ++i) {
+                    relinearize[i] = _drift[i] > options.relinearize_threshold;
+                }
+                const std::size_t relinearized = parallel_reduce(std::size_t(0), edge_count, std::size_t(0),
+                    [&](const std::size_t first, const std::size_t last) {
+                    std::size_t count = 0;
+                    for (std::size_t e=first; e<last; ++e) {
+                        const Edge& edge = _edges[e];
+                        const qScalar* from = states[edge.from].data();
+                        const qScalar* to = states[edge.to].data();
+                        if (!_linearized[e] || relinearize[edge.from] || relinearize[edge.to]) {
+                            _linearize(from, to, measurements_conj[e].data(), _jacobian_from[e], _jacobian_to[e]);
+                            _linearized[e] = true;
+                            ++count;
+                        }
+                        qScalar r6[6];
+                        _residual(from, to, measurements_conj[e].data(), r6);
+                        linalg::mul<6, 6>(edge.information, r6, weighted_residual[e].data());
+                    }
+                    return count;
+                }, [](const std::size_t a, const std::size_t b) { return a + b; }, threads, 256);
+                report.relinearized_edges += relinearized;
+                for (std::size_t i=0; i<node_count; ++i) {
+                    if (relinearize[i]) _drift[i] = 0;
+                }
+                // gradient J^T W r and diagonal blocks J^T W J of every free node
+                parallel_for(0, node_count, [&](const std::size_t first, const std::size_t last, std::size_t) {
+                    for (std::size_t i=first; i<last; ++i) {
+                        gradient[i].fill(0);
+                        diagonal[i].fill(0);
+                        if (fixed[i]) continue;
+                        for (std::size_t k=incident_offset[i]; k<incident_offset[i+1]; ++k) {
+                            const std::size_t e = incident[k];
+                            const Mat66& jacobian = _edges[e].from == i ? _jacobian_from[e] : _jacobian_to[e];
+                            Vec6 g;
+                            linalg::mul_transposed<6, 6>(jacobian, weighted_residual[e].data(), g.data());
+                            for (int j=0; j<6; ++j) gradient[i][j] += g[j];
+                            linalg::add_congruence<6, 6>(jacobian, _edges[e].information, jacobian, diagonal[i]);
+                        }
+                    }
+                }, threads, 256);
+                // off-diagonal blocks J_from^T W J_to
+                if (sparse) {
+                    parallel_for(0, edge_count, [&](const std::size_t first, const std::size_t last, std::size_t) {
+                        for (std::size_t e=first; e<last; ++e) {
+                            off_diagonal[e].fill(0);
+                            linalg::add_congruence<6, 6>(_jacobian_from[e], _edges[e].information, _jacobian_to[e], off_diagonal[e]);
+                        }
+                    }, threads, 256);
+                }
+                linearization_valid = true;
+            }
+            qScalar gradient_norm2 = 0;
+            for (std::size_t i=0; i<node_count; ++i) {
+                for (int j=0; j<6; ++j) gradient_norm2 += gradient[i][j] * gradient[i][j];
+            }
+            if (gradient_norm2 == 0) {
+                break;
+            }
+            // damping floor, so that free directions with a vanishing diagonal are damped too
+            qScalar max_diagonal = 0;
+            for (std::size_t i=0; i<node_count; ++i) {
+                if (fixed[i]) continue;
+                for (int j=0; j<6; ++j) max_diagonal = std::max(max_diagonal, diagonal[i][j*6 + j]);
+            }
+            const qScalar damping_floor = std::numeric_limits<qScalar>::epsilon() * max_diagonal;
+            if (sparse) {
+                // (H + lambda max(diag(H), floor)) delta = -g by sparse Cholesky
+                factorization.reset();
+                for (std::size_t i=0; i<node_count; ++i) {
+                    if (fixed[i]) continue;
+                    Mat66 block = diagonal[i];
+                    for (int j=0; j<6; ++j) block[j*6 + j] += lambda * std::max(diagonal[i][j*6 + j], damping_floor);
+                    factorization.add_diagonal(variable[i], block);
+                    for (int j=0; j<6; ++j) rhs[6*variable[i] + j] = -gradient[i][j];
+                }
+                for (std::size_t e=0; e<edge_count; ++e) {
+                    const Edge& edge = _edges[e];
+                    if (!fixed[edge.from] && !fixed[edge.to]) factorization.add_off_diagonal(variable[edge.from], variable[edge.to], off_diagonal[e]);
+                }
+                if (!factorization.factorize()) {
+                    lambda = lambda == 0 ? qScalar(1e-5) : lambda * 10;
+                    continue;
+                }
+                factorization.solve(rhs.data());
+                for (std::size_t i=0; i<node_count; ++i) {
+                    delta[i].fill(0);
+                    if (!fixed[i]) std::copy(rhs.begin() + 6*variable[i], rhs.begin() + 6*variable[i] + 6, delta[i].begin());
+                }
+            } else {
+                // damped block preconditioner
+                parallel_for(0, node_count, [&](const std::size_t first, const std::size_t last, std::size_t) {
+                    for (std::size_t i=first; i<last; ++i) {
+                        if (fixed[i]) continue;
+                        preconditioner[i] = diagonal[i];
+                        for (int j=0; j<6; ++j) preconditioner[i][j*6 + j] += lambda * std::max(diagonal[i][j*6 + j], damping_floor);
+                        if (!linalg::cholesky<6>(preconditioner[i])) {
+                            preconditioner[i] = _identity();
+                        }
+                    }
+                }, threads, 256);
+                // preconditioned conjugate gradients on (H + lambda max(diag(H), floor)) delta = -g, in one parallel region:
+                // every worker owns a range of edges and of nodes, meets the others at a barrier between the steps
+                // and sums the partial dot products of all workers in the same order, so all take the same branches
+                const std::size_t workers = parallel_chunks(0, std::max(node_count, edge_count), threads, 256);
+                std::vector<qScalar> rz_partial(workers), rr_partial(workers), pq_partial(workers);
+                const auto sum = [&](const std::vector<qScalar>& partials) {
+                    qScalar res = 0;
+                    for (const qScalar partial : partials) res += partial;
+                    return res;
+                };
+                std::barrier sync(static_cast<std::ptrdiff_t>(workers));
+                parallel_for(0, workers, [&](std::size_t, std::size_t, const std::size_t worker) {
+                    const std::size_t node_first = node_count * worker / workers, node_last = node_count * (worker + 1) / workers;
+                    const std::size_t edge_first = edge_count * worker / workers, edge_last = edge_count * (worker + 1) / workers;
+                    const auto precondition = [&]() {
+                        qScalar rz = 0;
+                        for (std::size_t i=node_first; i<node_last; ++i) {
+                            cg_z[i] = cg_r[i];
+                            if (!fixed[i]) linalg::cholesky_solve<6>(preconditioner[i], cg_z[i].data());
+                            for (int j=0; j<6; ++j) rz += cg_r[i][j] * cg_z[i][j];
+                        }
+                        return rz;
+                    };
+                    qScalar rr = 0;
+                    for (std::size_t i=node_first; i<node_last; ++i) {
+                        delta[i].fill(0);
+                        for (int j=0; j<6; ++j) cg_r[i][j] = fixed[i] ? 0 : -gradient[i][j];
+                        for (int j=0; j<6; ++j) rr += cg_r[i][j] * cg_r[i][j];
+                    }
+                    rz_partial[worker] = precondition();
+                    rr_partial[worker] = rr;
+                    for (std::size_t i=node_first; i<node_last; ++i) cg_p[i] = cg_z[i];
+                    sync.arrive_and_wait();
+                    qScalar rz = sum(rz_partial);
+                    const qScalar r0_norm2 = sum(rr_partial);
+                    for (std::size_t k=0; k<options.max_cg_iterations; ++k) {
+                        if (worker == 0) ++report.cg_iterations;
+                        // q = (H + lambda max(diag(H), floor)) p, evaluated edge by edge then gathered node by node
+                        for (std::size_t e=edge_first; e<edge_last; ++e) {
+                            Vec6 jx_from, jx_to, jx;
+                            linalg::mul<6, 6>(_jacobian_from[e], cg_p[_edges[e].from].data(), jx_from.data());
+                            linalg::mul<6, 6>(_jacobian_to[e], cg_p[_edges[e].to].data(), jx_to.data());
+                            for (int j=0; j<6; ++j) jx[j] = jx_from[j] + jx_to[j];
+                            linalg::mul<6, 6>(_edges[e].information, jx.data(), weighted_product[e].data());
+                        }
+                        sync.arrive_and_wait();
+                        qScalar pq = 0;
+                        for (std::size_t i=node_first; i<node_last; ++i) {
+                            cg_q[i].fill(0);
+                            if (fixed[i]) continue;
+                            for (std::size_t n=incident_offset[i]; n<incident_offset[i+1]; ++n) {
+                                const std::size_t e = incident[n];
+                                const Mat66& jacobian = _edges[e].from == i ? _jacobian_from[e] : _jacobian_to[e];
+                                Vec6 jt;
+                                linalg::mul_transposed<6, 6>(jacobian, weighted_product[e].data(), jt.data());
+                                for (int j=0; j<6; ++j) cg_q[i][j] += jt[j];
+                            }
+                            for (int j=0; j<6; ++j) cg_q[i][j] += lambda * std::max(diagonal[i][j*6 + j], damping_floor) * cg_p[i][j];
+                            for (int j=0; j<6; ++j) pq += cg_p[i][j] * cg_q[i][j];
+                        }
+                        pq_partial[worker] = pq;
+                        sync.arrive_and_wait();
+                        pq = sum(pq_partial);
+                        if (!(pq > 0)) break;
+                        const qScalar alpha = rz / pq;
+                        rr = 0;
+                        for (std::size_t i=node_first; i<node_last; ++i) {
+                            for (int j=0; j<6; ++j) {
+                                delta[i][j] += alpha * cg_p[i][j];
+                                cg_r[i][j] -= alpha * cg_q[i][j];
+                                rr += cg_r[i][j] * cg_r[i][j];
+                            }
+                        }
+                        rr_partial[worker] = rr;
+                        sync.arrive_and_wait();
+                        if (sum(rr_partial) <= square(options.cg_tolerance) * r0_norm2) break;
+                        rz_partial[worker] = precondition();
+                        sync.arrive_and_wait();
+                        const qScalar rz_next = sum(rz_partial);
+                        const qScalar beta = rz_next / rz;
+                        rz = rz_next;
+                        for (std::size_t i=node_first; i<node_last; ++i) {
+                            for (int j=0; j<6; ++j) cg_p[i][j] = cg_z[i][j] + beta * cg_p[i][j];
+                        }
+                        // p complete before the next product reads it
+                        sync.arrive_and_wait();
+                    }
+                }, workers, 1);
+            }
+            // try the step
+            for (std::size_t i=0; i<node_count; ++i) {
+                if (fixed[i]) {
+                    candidates[i] = states[i];
+                } else {
+                    _retract(states[i].data(), delta[i].data(), candidates[i].data());
+                }
+            }
+            const qScalar candidate_error = _total_error(candidates, measurements_conj, threads);
+            if (candidate_error < current_error) {
+                const qScalar decrease = (current_error - candidate_error) / current_error;
+                states.swap(candidates);
+                for (std::size_t i=0; i<node_count; ++i) {
+                    qScalar norm2 = 0;
+                    for (int j=0; j<6; ++j) norm2 += delta[i][j] * delta[i][j];
+                    _drift[i] += std::sqrt(norm2);
+                }
+                current_error = candidate_error;
+                lambda /= 3;
+                linearization_valid = false;
+                if (decrease < options.tolerance) break;
+            } else {
+                lambda = lambda == 0 ? qScalar(1e-5) : lambda * 10;
+            }
+        }
+        for (std::size_t i=0; i<node_count; ++i) {
+            kernel::dualquat_renormalize(states[i].data());
+            _nodes[i] = Pose<qScalar>(DualQuat<qScalar>(states[i]));
+        }
+        report.final_error = current_error;
+        return report;
+    }
+};
+
+using PoseGraphf = PoseGraph<float>;
+using PoseGraphd = PoseGraph<double>;
+using PoseGraphld = PoseGraph<long double>;
+
+}  // namespace dqpose
@@ -30,10 +30,17 @@
  */
 
 #pragma once
+#ifndef DQPOSE_NO_IOSTREAM
 #include <iostream>
 #include <iomanip>
+#endif
+#include <string>
+#include <cstdio>
 #include <cmath>
 #include <array>
+#include <concepts>
+#include "half.hpp"
+#include "kernel.hpp"
 
 namespace dqpose
 {
@@ -45,21 +52,55 @@ constexpr inline T square(const T& x) {
 
 constexpr int PRINT_PRECISION = 12;
 
+// format_fixed, value in fixed notation with PRINT_PRECISION decimals, as std::fixed with std::setprecision prints it
+inline std::string format_fixed(const long double value) {
+    const int size = std::snprintf(nullptr, 0, "%.*Lf", PRINT_PRECISION, value);
+    std::string res(static_cast<std::size_t>(size), '\0');
+    std::snprintf(res.data(), res.size() + 1, "%.*Lf", PRINT_PRECISION, value);
+    return res;
+}
+
+// QuatScalar, built-in arithmetic types, or any type that converts to and from float
+// and supports the arithmetic operators, e.g. Half, BFloat16 or a user fixed-point type
+template<typename T>
+concept QuatScalar = std::is_arithmetic_v<T> || (std::copy_constructible<T> && requires(T a, T b, float f) {
+    { T(f) };
+    { static_cast<float>(a) };
+    { a + b } -> std::convertible_to<T>;
+    { a - b } -> std::convertible_to<T>;
+    { a * b } -> std::convertible_to<T>;
+    { a / b } -> std::convertible_to<T>;
+    { -a } -> std::convertible_to<T>;
+    { a == b } -> std::convertible_to<bool>;
+    { a < b } -> std::convertible_to<bool>;
+});
+
+// Unnormalized, tag of the unit type constructors that keep components already unit as they are, e.g. read back
+// from a log, instead of renormalizing them
+struct Unnormalized { explicit Unnormalized()=default; };
+inline constexpr Unnormalized unnormalized{ };
+
 // Forward declarations
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class Quat;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class PureQuat;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class UnitQuat;
-template<typename qScalar, typename = std::enable_if_t<std::is_arithmetic_v<qScalar>>>
+template<QuatScalar qScalar>
 class UnitPureQuat;
+template<QuatScalar qScalar>
+class DualQuat;
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class Quat {
 public:
 protected:
     std::array<qScalar, 4> _data;
+    template<QuatScalar Scalar> friend class Quat;
+    template<QuatScalar Scalar> friend class DualQuat;
+    template<typename Scalar1, typename Scalar2, typename Scalar3>
+    friend constexpr void compose_into(Quat<Scalar1>& out, const Quat<Scalar2>& a, const Quat<Scalar3>& b) noexcept;
     constexpr inline qScalar& _w() noexcept {return _data[0];};
     constexpr inline qScalar& _x() noexcept {return _data[1];};
     constexpr inline qScalar& _y() noexcept {return _data[2];};
@@ -116,14 +157,7 @@ public:
     // operator*=
     template<typename Scalar>
     constexpr inline Quat& operator*=(const Quat<Scalar>& other) noexcept {
-        const qScalar other_w = static_cast<qScalar>(other.w());
-        const qScalar other_x = static_cast<qScalar>(other.x());
-        const qScalar other_y = static_cast<qScalar>(other.y());
-        const qScalar other_z = static_cast<qScalar>(other.z());
-        _w() = w()*other_w - x()*other_x - y()*other_y - z()*other_z;  
-        _x() = x()*other_w + w()*other_x - z()*other_y + y()*other_z; 
-        _y() = y()*other_w + z()*other_x + w()*other_y - x()*other_z; 
-        _z() = z()*other_w - y()*other_x + x()*other_y + w()*other_z; 
+        compose_into(*this, *this, other);
         return *this;
     }
     // operator*=
@@ -148,6 +182,53 @@ public:
         _w() = 0;
         return *this;
     }
+    // conj_inplace
+    constexpr inline Quat& conj_inplace() noexcept {
+        _x() = -x();
+        _y() = -y();
+        _z() = -z();
+        return *this;
+    }
+    // inv_inplace
+    constexpr inline Quat& inv_inplace() noexcept {
+        const qScalar norm2 = square( w() ) + square( x() ) + square( y() ) + square( z() );
+        _w() = w() / norm2;
+        _x() = - x() / norm2;
+        _y() = - y() / norm2;
+        _z() = - z() / norm2;
+        return *this;
+    }
+    // log_inplace
+    constexpr inline Quat& log_inplace() noexcept {
+        const qScalar vec3_norm = std::sqrt( square( x() ) + square( y() ) + square( z() ));
+        if (vec3_norm == 0) {
+            _w() = std::log(w());
+            return *this;
+        }
+        const qScalar this_norm = norm();
+        const qScalar this_theta = acos(w() / this_norm);
+        _w() = std::log(this_norm);
+        _x() = this_theta * x() / vec3_norm;
+        _y() = this_theta * y() / vec3_norm;
+        _z() = this_theta * z() / vec3_norm;
+        return *this;
+    }
+    // exp_inplace
+    constexpr inline Quat& exp_inplace() noexcept {
+        const qScalar vec3_norm = std::sqrt( square( x() ) + square( y() ) + square( z() ));
+        const qScalar exp_ = std::exp(w());
+        if (vec3_norm == 0) {
+            _w() = exp_;
+            return *this;
+        }
+        const qScalar cos_ = cos(vec3_norm);
+        const qScalar sin_ = sin(vec3_norm);
+        _w() = exp_ * cos_;
+        _x() = exp_ * sin_ * x() / vec3_norm;
+        _y() = exp_ * sin_ * y() / vec3_norm;
+        _z() = exp_ * sin_ * z() / vec3_norm;
+        return *this;
+    }
     // operator+
     template<typename Scalar>
     constexpr inline Quat operator+(const Quat<Scalar>& other) const noexcept {
@@ -169,15 +250,9 @@ public:
     // operator*
     template<typename Scalar>
     constexpr inline Quat operator*(const Quat<Scalar>& other) const noexcept {
-        const qScalar other_w = static_cast<qScalar>(other.w());
-        const qScalar other_x = static_cast<qScalar>(other.x());
-        const qScalar other_y = static_cast<qScalar>(other.y());
-        const qScalar other_z = static_cast<qScalar>(other.z());
-        const qScalar result_w = w()*other_w - x()*other_x - y()*other_y - z()*other_z;  
-        const qScalar result_x = x()*other_w + w()*other_x - z()*other_y + y()*other_z; 
-        const qScalar result_y = y()*other_w + z()*other_x + w()*other_y - x()*other_z; 
-        const qScalar result_z = z()*other_w - y()*other_x + x()*other_y + w()*other_z; 
-        return Quat(result_w, result_x, result_y, result_z);
+        Quat res;
+        compose_into(res, *this, other);
+        return res;
     }
     // operator*
     constexpr inline Quat operator*(const qScalar scalar) const noexcept {
@@ -221,67 +296,67 @@ public:
     }
     // conj
     constexpr inline Quat conj() const noexcept {
-        const qScalar result_w = w();  
-        const qScalar result_x = - x(); 
-        const qScalar result_y = - y(); 
-        const qScalar result_z = - z(); 
-        return Quat(result_w, result_x, result_y, result_z);  
+        Quat res;
+        conj_to(res);
+        return res;
     }
     // inv
     constexpr inline Quat inv() const noexcept {
-        const qScalar norm2 = square(norm());
-        const qScalar result_w = w() / norm2;  
-        const qScalar result_x = - x() / norm2; 
-        const qScalar result_y = - y() / norm2; 
-        const qScalar result_z = - z() / norm2; 
-        return Quat(result_w, result_x, result_y, result_z);  
+        Quat res;
+        inv_to(res);
+        return res;
     }
     // log
     constexpr inline Quat log() const noexcept {
-        const qScalar vec3_norm = std::sqrt( square( x() ) + square( y() ) + square( z() ));
-        if (vec3_norm == 0) {
-            return Quat(std::log(w()));
-        }
-        const qScalar this_norm = norm();
-        const qScalar this_theta = acos(w() / this_norm);
-        const qScalar result_w = std::log(this_norm);
-        const qScalar result_x = this_theta * x() / vec3_norm;
-        const qScalar result_y = this_theta * y() / vec3_norm;
-        const qScalar result_z = this_theta * z() / vec3_norm;
-        return Quat(result_w, result_x, result_y, result_z);  
+        Quat res;
+        log_to(res);
+        return res;
     }
     // exp
-    constexpr inline Quat exp() const noexcept {        
-        const qScalar vec3_norm = std::sqrt( square( x() ) + square( y() ) + square( z() ));
-        const qScalar exp_ = std::exp(w());        
-        if (vec3_norm == 0) {
-            return Quat(exp_);
-        }
-        const qScalar cos_ = cos(vec3_norm);
-        const qScalar sin_ = sin(vec3_norm);
-        const qScalar result_w = exp_ * cos_;
-        const qScalar result_x = exp_ * sin_ * x() / vec3_norm;
-        const qScalar result_y = exp_ * sin_ * y() / vec3_norm;
-        const qScalar result_z = exp_ * sin_ * z() / vec3_norm;
-        return Quat(result_w, result_x, result_y, result_z); 
-    }
+    constexpr inline Quat exp() const noexcept {
+        Quat res;
+        exp_to(res);
+        return res;
+    }
+    // conj_to, inv_to, log_to, exp_to, write the result into out, which may be *this
+    constexpr inline void conj_to(Quat& out) const noexcept {
+        out._data = _data;
+        out.conj_inplace();
+    }
+    constexpr inline void inv_to(Quat& out) const noexcept {
+        out._data = _data;
+        out.inv_inplace();
+    }
+    constexpr inline void log_to(Quat& out) const noexcept {
+        out._data = _data;
+        out.log_inplace();
+    }
+    constexpr inline void exp_to(Quat& out) const noexcept {
+        out._data = _data;
+        out.exp_inplace();
+    }
+    // log_to, exp_to, their results are general Quaternions, out of a derived type would lose its invariant
+    template<typename Out>
+    constexpr inline void log_to(Out& out) const noexcept =delete;
+    template<typename Out>
+    constexpr inline void exp_to(Out& out) const noexcept =delete;
     // pow
     constexpr inline Quat pow(const qScalar index) const noexcept{
         return (this->log() * index).exp();
     }
     // hamiplus
     constexpr inline std::array<std::array<qScalar, 4>, 4> hamiplus() const noexcept {
-        return std::array<std::array<qScalar, 4>, 4> { { w(), -x(), -y(), -z() },
+        return std::array<std::array<qScalar, 4>, 4> {{ { w(), -x(), -y(), -z() },
                                                     { x(),  w(), -z(),  y() },
                                                     { y(),  z(),  w(), -x() },
-                                                    { z(), -y(),  x(),  w() } };
+                                                    { z(), -y(),  x(),  w() } }};
     }
     // haminus
     constexpr inline std::array<std::array<qScalar, 4>, 4> haminus() const noexcept {
-        return std::array<std::array<qScalar, 4>, 4> { { w(), -x(), -y(), -z() },
+        return std::array<std::array<qScalar, 4>, 4> {{ { w(), -x(), -y(), -z() },
                                                     { x(),  w(),  z(), -y() },
                                                     { y(), -z(),  w(),  x() },
-                                                    { z(),  y(), -x(),  w() } };            
+                                                    { z(),  y(), -x(),  w() } }};            
     }
     // Query const
     constexpr inline qScalar w() const noexcept {return _data[0];}
@@ -290,9 +365,8 @@ public:
     constexpr inline qScalar z() const noexcept {return _data[3];}
     // to_string
     constexpr inline std::string to_string() const {    
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(PRINT_PRECISION) << w() << " + " << x() << " î + " << y() << " ĵ + " << z() << " k̂";
-        return oss.str();
+        return format_fixed(static_cast<long double>(w())) + " + " + format_fixed(static_cast<long double>(x())) + " î + "
+             + format_fixed(static_cast<long double>(y())) + " ĵ + " + format_fixed(static_cast<long double>(z())) + " k̂";
     };
     // data
     constexpr inline const qScalar* data() const noexcept { return _data.data(); }
@@ -308,7 +382,7 @@ public:
     Quat& operator=(Quat&&)=default;
 };
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class PureQuat: public Quat<qScalar>
 { 
 public:
@@ -377,6 +451,8 @@ public:
     constexpr inline Quat<qScalar>& operator-=(const Quat<Scalar>& other) noexcept =delete;
     template<typename Scalar>
     constexpr inline Quat<qScalar>& operator*=(const Quat<Scalar>& other) noexcept =delete;
+    constexpr inline Quat<qScalar>& log_inplace() noexcept =delete;
+    constexpr inline Quat<qScalar>& exp_inplace() noexcept =delete;
     // Defaults
         virtual ~PureQuat()=default;
                 PureQuat(const PureQuat&)=default;
@@ -385,7 +461,7 @@ public:
     PureQuat& operator=(PureQuat&&)=default;
 };
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class UnitQuat : public Quat<qScalar>
 {
 public:
@@ -404,6 +480,11 @@ public:
         : Quat<qScalar>( w, x, y, z ) {
         this->normalize();
     }
+    // Unnormalized Scalar Constructor, the components must already be unit
+    constexpr explicit UnitQuat(Unnormalized, const qScalar w, const qScalar x, const qScalar y, const qScalar z) noexcept
+        : Quat<qScalar>( w, x, y, z ) {
+
+    }
     // Quat Constructor
     template<typename Scalar>
     constexpr UnitQuat(const Quat<Scalar>& other) noexcept
@@ -423,14 +504,7 @@ public:
     // operator*=
     template<typename Scalar>
     constexpr inline UnitQuat& operator*=(const UnitQuat<Scalar>& other) noexcept {
-        const qScalar other_w = static_cast<qScalar>(other.w());
-        const qScalar other_x = static_cast<qScalar>(other.x());
-        const qScalar other_y = static_cast<qScalar>(other.y());
-        const qScalar other_z = static_cast<qScalar>(other.z());
-        this->_w() = this->w()*other_w - this->x()*other_x - this->y()*other_y - this->z()*other_z; 
-        this->_x() = this->x()*other_w + this->w()*other_x - this->z()*other_y + this->y()*other_z; 
-        this->_y() = this->y()*other_w + this->z()*other_x + this->w()*other_y - this->x()*other_z; 
-        this->_z() = this->z()*other_w - this->y()*other_x + this->x()*other_y + this->w()*other_z; 
+        compose_into(*this, *this, other);
         this->normalize();
         return *this;
     }
@@ -442,6 +516,8 @@ public:
     template<typename Scalar>
     constexpr inline Quat<qScalar>& operator*=(const Quat<Scalar>& other) noexcept =delete;
     constexpr inline Quat<qScalar>& operator*=(const qScalar scalar) noexcept =delete;   
+    constexpr inline Quat<qScalar>& log_inplace() noexcept =delete;
+    constexpr inline Quat<qScalar>& exp_inplace() noexcept =delete;
     // Defaults
         virtual ~UnitQuat()=default;
                 UnitQuat(const UnitQuat&)=default;
@@ -450,7 +526,7 @@ public:
     UnitQuat& operator=(UnitQuat&&)=default;
 };
 
-template<typename qScalar, typename>
+template<QuatScalar qScalar>
 class UnitPureQuat : public Quat<qScalar>
 {
 public:
@@ -493,6 +569,8 @@ public:
     template<typename Scalar>
     constexpr inline Quat<qScalar>& operator*=(const Quat<Scalar>& ) noexcept =delete;
     constexpr inline Quat<qScalar>& operator*=(const qScalar& ) noexcept =delete;
+    constexpr inline Quat<qScalar>& log_inplace() noexcept =delete;
+    constexpr inline Quat<qScalar>& exp_inplace() noexcept =delete;
     // Default
             virtual ~UnitPureQuat()=default;
                     UnitPureQuat(const UnitPureQuat&)=default;
@@ -500,16 +578,35 @@ public:
     UnitPureQuat& operator=(const UnitPureQuat&)=default;
     UnitPureQuat& operator=(UnitPureQuat&&)=default;
 };
+#ifndef DQPOSE_NO_IOSTREAM
 // operator<<
 template<typename Scalar>
 inline std::ostream& operator<<(std::ostream& os, const Quat<Scalar>& quat) {
     os << quat.to_string();  
     return os;
 }
+#endif
 // operator*
-template<typename Scalar1, typename Scalar2> 
-inline std::enable_if_t<std::is_arithmetic_v<Scalar1>, Quat<Scalar2>>
+template<QuatScalar Scalar1, typename Scalar2> 
+inline Quat<Scalar2>
 operator*(const Scalar1 scalar, const Quat<Scalar2>& quat) noexcept {return quat * scalar;}
+// compose_into, out = a b without temporaries, out may alias a or b
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(Quat<Scalar1>& out, const Quat<Scalar2>& a, const Quat<Scalar3>& b) noexcept {
+    kernel::quat_mul(a._data.data(), b._data.data(), out._data.data());
+}
+// compose_into, into a Unit Quaternion, only of Unit Quaternions
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(UnitQuat<Scalar1>& out, const UnitQuat<Scalar2>& a, const UnitQuat<Scalar3>& b) noexcept {
+    compose_into(static_cast<Quat<Scalar1>&>(out), a, b);
+}
+// compose_into, the product is no longer pure, or unit unless both factors are
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(UnitQuat<Scalar1>& out, const Quat<Scalar2>& a, const Quat<Scalar3>& b) noexcept =delete;
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(PureQuat<Scalar1>& out, const Quat<Scalar2>& a, const Quat<Scalar3>& b) noexcept =delete;
+template<typename Scalar1, typename Scalar2, typename Scalar3>
+constexpr inline void compose_into(UnitPureQuat<Scalar1>& out, const Quat<Scalar2>& a, const Quat<Scalar3>& b) noexcept =delete;
 
 using Quatf = Quat<float>;
 using UnitQuatf = UnitQuat<float>;
@@ -523,5 +620,26 @@ using Quatld = Quat<long double>;
 using UnitQuatld = UnitQuat<long double>;
 using PureQuatld = PureQuat<long double>;
 using UnitPureQuatld = UnitPureQuat<long double>;
+using Quath = Quat<Half>;
+using UnitQuath = UnitQuat<Half>;
+using PureQuath = PureQuat<Half>;
+using UnitPureQuath = UnitPureQuat<Half>;
+using Quatbf = Quat<BFloat16>;
+using UnitQuatbf = UnitQuat<BFloat16>;
+using PureQuatbf = PureQuat<BFloat16>;
+using UnitPureQuatbf = UnitPureQuat<BFloat16>;
+
+#ifdef DQPOSE_USE_LIBRARY
+// instantiated once in the dqpose library, see src/dqpose.cpp
+#define DQPOSE_EXTERN_QUAT(Scalar) \
+    extern template class Quat<Scalar>; \
+    extern template class PureQuat<Scalar>; \
+    extern template class UnitQuat<Scalar>; \
+    extern template class UnitPureQuat<Scalar>;
+DQPOSE_EXTERN_QUAT(float)
+DQPOSE_EXTERN_QUAT(double)
+DQPOSE_EXTERN_QUAT(long double)
+#undef DQPOSE_EXTERN_QUAT
+#endif
 
 }
\ No newline at end of file
@@ -0,0 +1,252 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/registration.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining closed-form point set registration
+ *
+ *     This file provides RegistrationAccumulator and register_points,
+ *     which estimate the Pose taking source points onto corresponding
+ *     target points with Horn's quaternion method: the rotation is the
+ *     eigenvector of the largest eigenvalue of the 4x4 matrix built from
+ *     the cross-covariance, the translation maps the source centroid onto
+ *     the target centroid.
+ *
+ *     The weight, centroid and cross-covariance sums are gathered in one
+ *     pass, relative to a shift point to keep them well conditioned, over
+ *     SoA batches with independent lanes the compiler can vectorize. An
+ *     accumulator holds 22 scalars and needs no allocation, so an ICP
+ *     loop can keep one per thread and merge them with operator+=.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "linalg.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <stdexcept>
+
+namespace dqpose
+{
+
+namespace kernel
+{
+
+// accumulate_correspondences, sums[16] += { w, w p, w q, w p q^T } of the shifted points p = source - shift[0:3], q = target - shift[3:6],
+// in 4 independent lanes, weights may be null
+template<typename qScalar, typename Scalar>
+inline void accumulate_correspondences(const Scalar* source_x, const Scalar* source_y, const Scalar* source_z,
+                                       const Scalar* target_x, const Scalar* target_y, const Scalar* target_z,
+                                       const Scalar* weights, const std::size_t first, const std::size_t last,
+                                       const qScalar* shift6, qScalar* sums) noexcept {
+    constexpr std::size_t lanes = 4;
+    qScalar acc[16][lanes] = { };
+    const auto accumulate = [&](const std::size_t i, const std::size_t lane) {
+        const qScalar w = weights ? static_cast<qScalar>(weights[i]) : qScalar(1);
+        const qScalar p[3] = { static_cast<qScalar>(source_x[i]) - shift6[0],
+                               static_cast<qScalar>(source_y[i]) - shift6[1],
+                               static_cast<qScalar>(source_z[i]) - shift6[2] };
+        const qScalar q[3] = { static_cast<qScalar>(target_x[i]) - shift6[3],
+                               static_cast<qScalar>(target_y[i]) - shift6[4],
+                               static_cast<qScalar>(target_z[i]) - shift6[5] };
+        acc[0][lane] += w;
+        for (int a=0; a<3; ++a) {
+            const qScalar wp = w * p[a];
+            acc[1 + a][lane] += wp;
+            acc[4 + a][lane] += w * q[a];
+            for (int b=0; b<3; ++b) acc[7 + a*3 + b][lane] += wp * q[b];
+        }
+    };
+    std::size_t i = first;
+    for (; i + lanes <= last; i += lanes) {
+        for (std::size_t lane=0; lane<lanes; ++lane) accumulate(i + lane, lane);
+    }
+    for (; i<last; ++i) {
+        accumulate(i, 0);
+    }
+    for (int k=0; k<16; ++k) {
+        for (std::size_t lane=0; lane<lanes; ++lane) sums[k] += acc[k][lane];
+    }
+}
+
+}  // namespace kernel
+
+template<QuatScalar qScalar>
+class RegistrationAccumulator {
+protected:
+    // source shift then target shift
+    std::array<qScalar, 6> _shift;
+    // weight, weighted source sum, weighted target sum, weighted source target^T sum, all relative to the shifts
+    std::array<qScalar, 16> _sums;
+
+    // _reshift, expresses the sums relative to new shifts
+    constexpr inline void _reshift(const std::array<qScalar, 6>& shift) noexcept {
+        const qScalar weight = _sums[0];
+        qScalar d[3], e[3];
+        for (int a=0; a<3; ++a) {
+            d[a] = _shift[a] - shift[a];
+            e[a] = _shift[3 + a] - shift[3 + a];
+        }
+        for (int a=0; a<3; ++a) {
+            for (int b=0; b<3; ++b) {
+                _sums[7 + a*3 + b] += _sums[1 + a] * e[b] + d[a] * _sums[4 + b] + weight * d[a] * e[b];
+            }
+        }
+        for (int a=0; a<3; ++a) {
+            _sums[1 + a] += weight * d[a];
+            _sums[4 + a] += weight * e[a];
+        }
+        _shift = shift;
+    }
+public:
+    // Default Constructor
+    constexpr explicit RegistrationAccumulator() noexcept
+        : _shift{ }, _sums{ } {
+
+    }
+    // Shift Constructor, shifts close to the data, such as a first correspondence, keep the sums well conditioned
+    template<typename Scalar>
+    constexpr explicit RegistrationAccumulator(const Scalar* source_shift3, const Scalar* target_shift3) noexcept
+        : _shift{ }, _sums{ } {
+        for (int a=0; a<3; ++a) {
+            _shift[a] = static_cast<qScalar>(source_shift3[a]);
+            _shift[3 + a] = static_cast<qScalar>(target_shift3[a]);
+        }
+    }
+    // add, one correspondence
+    template<typename Scalar>
+    constexpr inline void add(const Scalar* source3, const Scalar* target3, const qScalar weight=1) noexcept {
+        const Scalar w = static_cast<Scalar>(weight);
+        kernel::accumulate_correspondences(source3, source3 + 1, source3 + 2, target3, target3 + 1, target3 + 2,
+                                           &w, 0, 1, _shift.data(), _sums.data());
+    }
+    // add, one correspondence
+    template<typename Scalar>
+    constexpr inline void add(const PureQuat<Scalar>& source, const PureQuat<Scalar>& target, const qScalar weight=1) noexcept {
+        const Scalar source3[3] = { source.x(), source.y(), source.z() };
+        const Scalar target3[3] = { target.x(), target.y(), target.z() };
+        add(source3, target3, weight);
+    }
+    // add, correspondences [first, last) of two batches, weights may be null
+    template<typename Scalar>
+    inline void add(const PureQuatBatch<Scalar>& source, const PureQuatBatch<Scalar>& target,
+                    const std::size_t first, const std::size_t last, const Scalar* weights=nullptr) noexcept {
+        kernel::accumulate_correspondences(source.data(0), source.data(1), source.data(2),
+                                           target.data(0), target.data(1), target.data(2),
+                                           weights, first, last, _shift.data(), _sums.data());
+    }
+    // operator+=
+    constexpr inline RegistrationAccumulator& operator+=(RegistrationAccumulator other) noexcept {
+        if (other._shift != _shift) {
+            other._reshift(_shift);
+        }
+        for (int k=0; k<16; ++k) _sums[k] += other._sums[k];
+        return *this;
+    }
+    // clear, keeps the shifts
+    constexpr inline void clear() noexcept { _sums.fill(0); }
+    // weight, total weight of the correspondences
+    constexpr inline qScalar weight() const noexcept { return _sums[0]; }
+    // source_centroid
+    constexpr inline PureQuat<qScalar> source_centroid() const {
+        if (!(_sums[0] > 0)) {
+            throw std::runtime_error("Error: RegistrationAccumulator::source_centroid() No weighted correspondence.");
+        }
+        return PureQuat<qScalar>(_shift[0] + _sums[1] / _sums[0], _shift[1] + _sums[2] / _sums[0], _shift[2] + _sums[3] / _sums[0]);
+    }
+    // target_centroid
+    constexpr inline PureQuat<qScalar> target_centroid() const {
+        if (!(_sums[0] > 0)) {
+            throw std::runtime_error("Error: RegistrationAccumulator::target_centroid() No weighted correspondence.");
+        }
+        return PureQuat<qScalar>(_shift[3] + _sums[4] / _sums[0], _shift[4] + _sums[5] / _sums[0], _shift[5] + _sums[6] / _sums[0]);
+    }
+    // rotation, Horn's closed form, the largest eigenvector of N(S) for the centered cross-covariance S
+    inline Rotation<qScalar> rotation() const {
+        const qScalar weight = _sums[0];
+        if (!(weight > 0)) {
+            throw std::runtime_error("Error: RegistrationAccumulator::rotation() No weighted correspondence.");
+        }
+        qScalar s[9];
+        for (int a=0; a<3; ++a) {
+            for (int b=0; b<3; ++b) s[a*3 + b] = _sums[7 + a*3 + b] - _sums[1 + a] * _sums[4 + b] / weight;
+        }
+        const qScalar xx = s[0], xy = s[1], xz = s[2];
+        const qScalar yx = s[3], yy = s[4], yz = s[5];
+        const qScalar zx = s[6], zy = s[7], zz = s[8];
+        const std::array<qScalar, 16> n = {
+            xx + yy + zz, yz - zy,       zx - xz,       xy - yx,
+            yz - zy,      xx - yy - zz,  xy + yx,       zx + xz,
+            zx - xz,      xy + yx,       -xx + yy - zz, yz + zy,
+            xy - yx,      zx + xz,       yz + zy,       -xx - yy + zz };
+        std::array<qScalar, 4> values;
+        std::array<qScalar, 16> vectors;
+        linalg::symmetric_eigen<4>(n, values, vectors);
+        return Rotation<qScalar>(vectors[3], vectors[7], vectors[11], vectors[15]);
+    }
+    // solve, the Pose taking the source points onto the target points
+    inline Pose<qScalar> solve() const {
+        const Rotation<qScalar> rotation = this->rotation();
+        const PureQuat<qScalar> source = source_centroid();
+        const PureQuat<qScalar> target = target_centroid();
+        const qScalar q[4] = { rotation.w(), rotation.x(), rotation.y(), rotation.z() };
+        const qScalar c[3] = { source.x(), source.y(), source.z() };
+        qScalar rotated[3];
+        kernel::quat_rotate(q, c, rotated);
+        return Pose<qScalar>(rotation, Translation<qScalar>(target.x() - rotated[0], target.y() - rotated[1], target.z() - rotated[2]));
+    }
+};
+
+// register_points, the Pose taking every source point onto its target, weights may be null
+template<QuatScalar cScalar=double, typename Scalar>
+inline Pose<cScalar> register_points(const PureQuatBatch<Scalar>& source, const PureQuatBatch<Scalar>& target,
+                                     const Scalar* weights=nullptr, const std::size_t threads=0) {
+    const std::size_t size = source.size();
+    if (target.size() != size) {
+        throw std::runtime_error("Error: register_points() Point batches differ in size.");
+    }
+    if (size == 0) {
+        throw std::runtime_error("Error: register_points() Empty point batches.");
+    }
+    Scalar source_shift[3], target_shift[3];
+    source.load(0, source_shift);
+    target.load(0, target_shift);
+    const RegistrationAccumulator<cScalar> empty(source_shift, target_shift);
+    const RegistrationAccumulator<cScalar> sums = parallel_reduce(std::size_t(0), size, empty,
+        [&](const std::size_t first, const std::size_t last) {
+        RegistrationAccumulator<cScalar> res = empty;
+        res.add(source, target, first, last, weights);
+        return res;
+    }, [](RegistrationAccumulator<cScalar> lhs, const RegistrationAccumulator<cScalar>& rhs) {
+        return lhs += rhs;
+    }, threads, 16384);
+    return sums.solve();
+}
+
+using RegistrationAccumulatorf = RegistrationAccumulator<float>;
+using RegistrationAccumulatord = RegistrationAccumulator<double>;
+using RegistrationAccumulatorld = RegistrationAccumulator<long double>;
+
+}  // namespace dqpose
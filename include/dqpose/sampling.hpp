@@ -0,0 +1,207 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/sampling.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining rotation samplers and grids
+ *
+ *     This file provides generators of many unit Quaternions at once,
+ *     written straight into QuatBatch storage without normalization: uniform
+ *     random rotations by Shoemake's method, the low discrepancy Halton
+ *     rotations obtained by feeding the Halton sequence in bases 2, 3 and 5
+ *     to the same map, and the deterministic grid of Yershova et al., a
+ *     HEALPix grid of the sphere times a circle grid, combined by the Hopf
+ *     fibration, 72 8^level rotations covering SO(3) evenly.
+ *
+ *     Every sample depends only on its index, the random ones through a
+ *     counter based generator, so outputs are identical for any number of
+ *     threads, and the generators split the work over parallel_for.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "parallel.hpp"
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dqpose
+{
+
+namespace kernel
+{
+
+// shoemake, the unit Quaternion of three uniforms in [0, 1), uniform on SO(3) for uniform inputs
+template<typename qScalar>
+inline void shoemake(const qScalar u1, const qScalar u2, const qScalar u3, qScalar* q) noexcept {
+    constexpr qScalar two_pi = 2 * std::numbers::pi_v<qScalar>;
+    const qScalar a = std::sqrt(1 - u1);
+    const qScalar b = std::sqrt(u1);
+    q[0] = b * std::cos(two_pi * u3);
+    q[1] = a * std::sin(two_pi * u2);
+    q[2] = a * std::cos(two_pi * u2);
+    q[3] = b * std::sin(two_pi * u3);
+}
+// counter_random, the index-th 64 random bits of the stream seed, splitmix64 of the counter
+constexpr inline std::uint64_t counter_random(const std::uint64_t seed, const std::uint64_t index) noexcept {
+    std::uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+// unit_uniform, 53 or 24 random bits as a uniform in [0, 1)
+template<typename qScalar>
+constexpr inline qScalar unit_uniform(const std::uint64_t bits) noexcept {
+    constexpr int digits = std::numeric_limits<qScalar>::digits < 64 ? std::numeric_limits<qScalar>::digits : 63;
+    return static_cast<qScalar>(bits >> (64 - digits)) / static_cast<qScalar>(std::uint64_t(1) << digits);
+}
+// radical_inverse, the index mirrored at the radix point in the base, the Halton coordinate
+template<typename qScalar>
+constexpr inline qScalar radical_inverse(std::uint64_t index, const std::uint64_t base) noexcept {
+    qScalar result = 0;
+    qScalar scale = qScalar(1) / static_cast<qScalar>(base);
+    for (; index != 0; index /= base, scale /= static_cast<qScalar>(base)) {
+        result += static_cast<qScalar>(index % base) * scale;
+    }
+    return result;
+}
+// healpix_center, z = cos(theta) and phi of the center of pixel p of the HEALPix ring scheme with nside pixels per base side
+template<typename qScalar>
+inline void healpix_center(const std::uint64_t nside, const std::uint64_t p, qScalar& z, qScalar& phi) noexcept {
+    constexpr qScalar pi = std::numbers::pi_v<qScalar>;
+    const std::uint64_t npix = 12 * nside * nside;
+    const std::uint64_t ncap = 2 * nside * (nside - 1);
+    const qScalar nside2 = static_cast<qScalar>(nside * nside);
+    if (p < ncap) {
+        // north polar cap
+        const std::uint64_t ring = static_cast<std::uint64_t>((1 + std::sqrt(static_cast<double>(1 + 2 * p))) / 2);
+        const std::uint64_t iphi = p + 1 - 2 * ring * (ring - 1);
+        z = 1 - static_cast<qScalar>(ring * ring) / (3 * nside2);
+        phi = (static_cast<qScalar>(iphi) - qScalar(0.5)) * pi / static_cast<qScalar>(2 * ring);
+    } else if (p < npix - ncap) {
+        // equatorial belt
+        const std::uint64_t ip = p - ncap;
+        const std::uint64_t ring = ip / (4 * nside) + nside;
+        const std::uint64_t iphi = ip % (4 * nside) + 1;
+        const qScalar shift = ((ring + nside) & 1) ? 1 : qScalar(0.5);
+        z = static_cast<qScalar>(2 * static_cast<std::int64_t>(nside) - static_cast<std::int64_t>(ring)) * 2 / (3 * static_cast<qScalar>(nside));
+        phi = (static_cast<qScalar>(iphi) - shift) * pi / static_cast<qScalar>(2 * nside);
+    } else {
+        // south polar cap
+        const std::uint64_t ip = npix - p;
+        const std::uint64_t ring = static_cast<std::uint64_t>((1 + std::sqrt(static_cast<double>(2 * ip - 1))) / 2);
+        const std::uint64_t iphi = 4 * ring + 1 - (ip - 2 * ring * (ring - 1));
+        z = -1 + static_cast<qScalar>(ring * ring) / (3 * nside2);
+        phi = (static_cast<qScalar>(iphi) - qScalar(0.5)) * pi / static_cast<qScalar>(2 * ring);
+    }
+}
+// hopf_rotation, the unit Quaternion of the sphere point (cos theta = z, phi) and the fiber angle psi
+template<typename qScalar>
+inline void hopf_rotation(const qScalar z, const qScalar phi, const qScalar psi, qScalar* q) noexcept {
+    // cos(theta / 2) and sin(theta / 2) from cos(theta)
+    const qScalar c = std::sqrt(std::max<qScalar>(0, (1 + z) / 2));
+    const qScalar s = std::sqrt(std::max<qScalar>(0, (1 - z) / 2));
+    q[0] = c * std::cos(psi / 2);
+    q[1] = c * std::sin(psi / 2);
+    q[2] = s * std::cos(phi + psi / 2);
+    q[3] = s * std::sin(phi + psi / 2);
+}
+
+}  // namespace kernel
+
+// random_rotation, the index-th uniform random rotation of the stream seed, as written by random_rotations
+template<typename qScalar>
+inline Rotation<qScalar> random_rotation(const std::uint64_t seed, const std::uint64_t index) noexcept {
+    using cScalar = std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>;
+    cScalar q[4];
+    kernel::shoemake(kernel::unit_uniform<cScalar>(kernel::counter_random(seed, 3 * index)),
+                     kernel::unit_uniform<cScalar>(kernel::counter_random(seed, 3 * index + 1)),
+                     kernel::unit_uniform<cScalar>(kernel::counter_random(seed, 3 * index + 2)), q);
+    return Rotation<qScalar>(q[0], q[1], q[2], q[3]);
+}
+
+// random_rotations, rotations resized to count uniform random rotations of the stream seed, the same for any threads
+template<typename Scalar>
+inline void random_rotations(QuatBatch<Scalar>& rotations, const std::size_t count, const std::uint64_t seed, const std::size_t threads=0) {
+    using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+    rotations.resize(count);
+    parallel_for(0, count, [&](const std::size_t first, const std::size_t last, std::size_t) {
+        for (std::size_t i=first; i<last; ++i) {
+            cScalar q[4];
+            kernel::shoemake(kernel::unit_uniform<cScalar>(kernel::counter_random(seed, 3 * i)),
+                             kernel::unit_uniform<cScalar>(kernel::counter_random(seed, 3 * i + 1)),
+                             kernel::unit_uniform<cScalar>(kernel::counter_random(seed, 3 * i + 2)), q);
+            rotations.store(i, q);
+        }
+    }, threads, 65536);
+}
+
+// halton_rotations, rotations resized to count low discrepancy rotations, the Halton points first + 1 to first + count
+// in bases 2, 3 and 5 mapped by kernel::shoemake, so successive calls extend the same sequence
+template<typename Scalar>
+inline void halton_rotations(QuatBatch<Scalar>& rotations, const std::size_t count, const std::uint64_t first=0, const std::size_t threads=0) {
+    using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+    rotations.resize(count);
+    parallel_for(0, count, [&](const std::size_t chunk_first, const std::size_t chunk_last, std::size_t) {
+        for (std::size_t i=chunk_first; i<chunk_last; ++i) {
+            const std::uint64_t index = first + i + 1;
+            cScalar q[4];
+            kernel::shoemake(kernel::radical_inverse<cScalar>(index, 2), kernel::radical_inverse<cScalar>(index, 3),
+                             kernel::radical_inverse<cScalar>(index, 5), q);
+            rotations.store(i, q);
+        }
+    }, threads, 65536);
+}
+
+// hopf_grid_size, rotations of the grid of a level, 12 4^level sphere pixels times 6 2^level fiber angles
+constexpr inline std::size_t hopf_grid_size(const unsigned int level) noexcept {
+    return std::size_t(72) << (3 * level);
+}
+
+// hopf_grid, rotations resized to the Hopf fibration grid of a level, HEALPix pixel centers with nside = 2^level and
+// evenly spaced fiber angles; its covering radius roughly halves per level, about 1 rad / 2^level
+template<typename Scalar>
+inline void hopf_grid(QuatBatch<Scalar>& rotations, const unsigned int level, const std::size_t threads=0) {
+    using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+    if (level > 16) {
+        throw std::runtime_error("Error: hopf_grid() Level must be at most 16.");
+    }
+    constexpr cScalar two_pi = 2 * std::numbers::pi_v<cScalar>;
+    const std::uint64_t nside = std::uint64_t(1) << level;
+    const std::uint64_t fibers = std::uint64_t(6) << level;
+    rotations.resize(hopf_grid_size(level));
+    parallel_for(0, rotations.size(), [&](const std::size_t first, const std::size_t last, std::size_t) {
+        for (std::size_t i=first; i<last; ++i) {
+            cScalar z, phi, q[4];
+            kernel::healpix_center(nside, i / fibers, z, phi);
+            const cScalar psi = (static_cast<cScalar>(i % fibers) + cScalar(0.5)) * two_pi / static_cast<cScalar>(fibers);
+            kernel::hopf_rotation(z, phi, psi, q);
+            rotations.store(i, q);
+        }
+    }, threads, 65536);
+}
+
+}  // namespace dqpose
@@ -0,0 +1,407 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/shm.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining pose exchange through shared memory
+ *
+ *     This file provides PosePublisher and PoseSubscriber, which exchange
+ *     timestamped Poses between processes of one host through a ring of
+ *     records in a POSIX shared memory segment. A publish is a few stores
+ *     and a read a few loads, no system call and no serialization: records
+ *     keep the 8 scalars of the Pose as they are in memory.
+ *
+ *     The segment holds a header, the count of published records and a
+ *     ring of capacity slots. Every slot is guarded by a seqlock, the
+ *     publisher makes its sequence odd while it writes the record, so
+ *     readers never wait: they copy a record and retry when its sequence
+ *     moved meanwhile. Subscribers read the latest record, a record by its
+ *     index, or the screw motion interpolation at a time between records
+ *     still in the ring. A segment has one publisher, any number of
+ *     subscribers, and records must be published in increasing time.
+ *
+ *     A publisher never resizes a segment that subscribers may have mapped:
+ *     it unlinks the name and creates a new segment under a new generation.
+ *     Subscribers keep reading their old mapping and move to the new one by
+ *     reopen, when closed tells the old publisher stopped or when records
+ *     stop coming after a crash. A publisher only unlinks the name on
+ *     destruction while it still names its own segment.
+ *
+ *     The segment is a POSIX one, dqpose.hpp includes this file only on
+ *     unix like systems.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "kernel.hpp"
+#include "stream.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace dqpose
+{
+
+struct SharedPoseOptions {
+    // records kept in the ring, at least 2, a subscriber can read back at most this far
+    std::size_t capacity = 1024;
+    // removes the segment name when the publisher is destroyed, mapped subscribers keep reading the last records
+    bool unlink = true;
+};
+
+namespace kernel
+{
+
+inline constexpr char shm_magic[8] = { 'D', 'Q', 'P', 'O', 'S', 'H', 'M', '1' };
+inline constexpr std::size_t shm_cache_line = 64;
+// shm_read_attempts, reads of a record overwritten meanwhile before giving up
+inline constexpr int shm_read_attempts = 64;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared memory records need lock-free 64 bit atomics.");
+
+// shm_header, at the start of the segment, magic is written last by the publisher
+struct alignas(shm_cache_line) shm_header {
+    std::atomic<std::uint64_t> magic;
+    std::uint32_t scalar_bytes;
+    std::uint32_t record_words;
+    std::uint64_t capacity;
+    // tells the segments of successive publishers of a name apart
+    std::uint64_t generation;
+    // set by the publisher when it is destroyed
+    std::atomic<std::uint64_t> closed;
+    alignas(shm_cache_line) std::atomic<std::uint64_t> head;
+};
+
+// shm_generation, a value that differs between publishers, from the clock and the process id
+inline std::uint64_t shm_generation() noexcept {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count())
+         ^ (static_cast<std::uint64_t>(::getpid()) << 40);
+}
+
+// shm_record_words, 64 bit words of one record, the double timestamp then the 8 scalars of the Pose
+template<typename qScalar>
+constexpr inline std::size_t shm_record_words() noexcept {
+    return (sizeof(double) + 8 * sizeof(qScalar) + 7) / 8;
+}
+
+// shm_slot_bytes, bytes of one slot, its sequence then its record, rounded to cache lines
+template<typename qScalar>
+constexpr inline std::size_t shm_slot_bytes() noexcept {
+    return (8 * (1 + shm_record_words<qScalar>()) + shm_cache_line - 1) / shm_cache_line * shm_cache_line;
+}
+
+// shm_segment_bytes
+template<typename qScalar>
+constexpr inline std::size_t shm_segment_bytes(const std::size_t capacity) noexcept {
+    return sizeof(shm_header) + capacity * shm_slot_bytes<qScalar>();
+}
+
+// shm_slot, the words of the slot of a record index, the sequence first
+template<typename qScalar>
+inline std::atomic<std::uint64_t>* shm_slot(void* segment, const std::uint64_t index, const std::uint64_t capacity) noexcept {
+    unsigned char* slots = static_cast<unsigned char*>(segment) + sizeof(shm_header);
+    return reinterpret_cast<std::atomic<std::uint64_t>*>(slots + (index % capacity) * shm_slot_bytes<qScalar>());
+}
+
+}  // namespace kernel
+
+template<QuatScalar qScalar>
+class PosePublisher {
+protected:
+    std::string _name;
+    SharedPoseOptions _options;
+    std::size_t _bytes;
+    void* _segment;
+    kernel::shm_header* _header;
+    std::uint64_t _count;
+    // the segment file, to tell it from one of a later publisher under the same name
+    dev_t _device;
+    ino_t _inode;
+public:
+    // Name Constructor, creates the segment, the name starts with a slash as for shm_open; a segment left under the name
+    // is unlinked, not resized, so subscribers still mapping it are not hurt
+    explicit PosePublisher(const std::string& name, const SharedPoseOptions& options=SharedPoseOptions())
+        : _name( name ), _options( options ), _bytes( kernel::shm_segment_bytes<qScalar>(options.capacity) ),
+          _segment( nullptr ), _header( nullptr ), _count( 0 ), _device( 0 ), _inode( 0 ) {
+        // the slot being written must differ from the last published one
+        if (_options.capacity < 2) {
+            throw std::runtime_error("Error: PosePublisher() Capacity must be at least 2.");
+        }
+        ::shm_unlink(name.c_str());
+        const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("Error: PosePublisher() Failed opening the segment " + name + ".");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || ::ftruncate(fd, static_cast<off_t>(_bytes)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("Error: PosePublisher() Failed sizing the segment " + name + ".");
+        }
+        _device = info.st_dev;
+        _inode = info.st_ino;
+        _segment = ::mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (_segment == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("Error: PosePublisher() Failed mapping the segment " + name + ".");
+        }
+        // a fresh segment is zero filled, every sequence is even and no record is published
+        _header = static_cast<kernel::shm_header*>(_segment);
+        _header->scalar_bytes = sizeof(qScalar);
+        _header->record_words = kernel::shm_record_words<qScalar>();
+        _header->capacity = _options.capacity;
+        _header->generation = kernel::shm_generation();
+        std::uint64_t magic;
+        std::memcpy(&magic, kernel::shm_magic, sizeof(magic));
+        _header->magic.store(magic, std::memory_order_release);
+    }
+    PosePublisher(const PosePublisher&)=delete;
+    PosePublisher& operator=(const PosePublisher&)=delete;
+    // Destructor, leaves the name alone once a later publisher took it over
+    virtual ~PosePublisher() {
+        _header->closed.store(1, std::memory_order_release);
+        ::munmap(_segment, _bytes);
+        if (_options.unlink && owns_name()) ::shm_unlink(_name.c_str());
+    }
+    // publish, one record given as 8 scalars
+    inline void publish(const double timestamp, const qScalar* arr8) noexcept {
+        constexpr std::size_t words = kernel::shm_record_words<qScalar>();
+        std::uint64_t record[words] = { };
+        std::memcpy(record, &timestamp, sizeof(double));
+        std::memcpy(reinterpret_cast<unsigned char*>(record) + sizeof(double), arr8, 8 * sizeof(qScalar));
+        std::atomic<std::uint64_t>* slot = kernel::shm_slot<qScalar>(_segment, _count, _options.capacity);
+        // odd while writing, readers of this slot retry
+        slot[0].store(2 * _count + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t k=0; k<words; ++k) slot[k+1].store(record[k], std::memory_order_relaxed);
+        slot[0].store(2 * _count + 2, std::memory_order_release);
+        _header->head.store(++_count, std::memory_order_release);
+    }
+    // publish, one record
+    template<typename Scalar>
+    inline void publish(const double timestamp, const DualQuat<Scalar>& pose) noexcept {
+        const Quat<Scalar> real = pose.real();
+        const Quat<Scalar> dual = pose.dual();
+        const qScalar arr8[8] = { static_cast<qScalar>(real.w()), static_cast<qScalar>(real.x()), static_cast<qScalar>(real.y()), static_cast<qScalar>(real.z()),
+                                  static_cast<qScalar>(dual.w()), static_cast<qScalar>(dual.x()), static_cast<qScalar>(dual.y()), static_cast<qScalar>(dual.z()) };
+        publish(timestamp, arr8);
+    }
+    // publish, one record
+    inline void publish(const StampedPose<qScalar>& record) noexcept {
+        publish(record.timestamp, record.pose);
+    }
+    // count, records published
+    inline std::uint64_t count() const noexcept { return _count; }
+    // capacity
+    inline std::size_t capacity() const noexcept { return _options.capacity; }
+    // name
+    inline const std::string& name() const noexcept { return _name; }
+    // generation
+    inline std::uint64_t generation() const noexcept { return _header->generation; }
+    // owns_name, the name still refers to the segment of this publisher
+    inline bool owns_name() const noexcept {
+        const int fd = ::shm_open(_name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat info;
+        const bool same = ::fstat(fd, &info) == 0 && info.st_dev == _device && info.st_ino == _inode;
+        ::close(fd);
+        return same;
+    }
+};
+
+template<QuatScalar qScalar>
+class PoseSubscriber {
+protected:
+    using cScalar = std::conditional_t<std::is_floating_point_v<qScalar>, qScalar, float>;
+    std::string _name;
+    std::size_t _bytes;
+    void* _segment;
+    const kernel::shm_header* _header;
+    std::uint64_t _capacity;
+
+    // _load, the record of an index as a timestamp and 8 scalars, false once overwritten or not yet published
+    inline bool _load(const std::uint64_t index, double& timestamp, qScalar* arr8) const noexcept {
+        constexpr std::size_t words = kernel::shm_record_words<qScalar>();
+        const std::atomic<std::uint64_t>* slot = kernel::shm_slot<qScalar>(_segment, index, _capacity);
+        const std::uint64_t expected = 2 * index + 2;
+        if (slot[0].load(std::memory_order_acquire) != expected) return false;
+        std::uint64_t record[words];
+        for (std::size_t k=0; k<words; ++k) record[k] = slot[k+1].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot[0].load(std::memory_order_relaxed) != expected) return false;
+        std::memcpy(&timestamp, record, sizeof(double));
+        std::memcpy(arr8, reinterpret_cast<const unsigned char*>(record) + sizeof(double), 8 * sizeof(qScalar));
+        return true;
+    }
+    // _pose, the published scalars as they are, not renormalized
+    static inline Pose<qScalar> _pose(const qScalar* arr8) noexcept {
+        return Pose<qScalar>(unnormalized, arr8[0], arr8[1], arr8[2], arr8[3], arr8[4], arr8[5], arr8[6], arr8[7]);
+    }
+public:
+    // Name Constructor, maps a segment of a running publisher
+    explicit PoseSubscriber(const std::string& name)
+        : _name( name ), _bytes( 0 ), _segment( nullptr ), _header( nullptr ), _capacity( 0 ) {
+        const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw std::runtime_error("Error: PoseSubscriber() Failed opening the segment " + name + ".");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(kernel::shm_header)) {
+            ::close(fd);
+            throw std::runtime_error("Error: PoseSubscriber() " + name + " is not a pose segment.");
+        }
+        _bytes = static_cast<std::size_t>(info.st_size);
+        _segment = ::mmap(nullptr, _bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (_segment == MAP_FAILED) {
+            throw std::runtime_error("Error: PoseSubscriber() Failed mapping the segment " + name + ".");
+        }
+        _header = static_cast<const kernel::shm_header*>(_segment);
+        const std::uint64_t magic = _header->magic.load(std::memory_order_acquire);
+        if (std::memcmp(&magic, kernel::shm_magic, sizeof(magic)) != 0) {
+            ::munmap(_segment, _bytes);
+            throw std::runtime_error("Error: PoseSubscriber() " + name + " is not a pose segment.");
+        }
+        if (_header->scalar_bytes != sizeof(qScalar)) {
+            ::munmap(_segment, _bytes);
+            throw std::runtime_error("Error: PoseSubscriber() " + name + " holds scalars of another size.");
+        }
+        _capacity = _header->capacity;
+        if (_capacity < 2 || kernel::shm_segment_bytes<qScalar>(_capacity) > _bytes) {
+            ::munmap(_segment, _bytes);
+            throw std::runtime_error("Error: PoseSubscriber() " + name + " is truncated.");
+        }
+    }
+    PoseSubscriber(const PoseSubscriber&)=delete;
+    PoseSubscriber& operator=(const PoseSubscriber&)=delete;
+    // Destructor
+    virtual ~PoseSubscriber() {
+        ::munmap(_segment, _bytes);
+    }
+    // generation, of the mapped segment
+    inline std::uint64_t generation() const noexcept { return _header->generation; }
+    // closed, the publisher of the mapped segment was destroyed, no record will follow
+    inline bool closed() const noexcept { return _header->closed.load(std::memory_order_acquire) != 0; }
+    // reopen, maps the segment the name holds now, true when it is of another generation; throws as the constructor,
+    // keeping the current mapping
+    inline bool reopen() {
+        PoseSubscriber other(_name);
+        const bool changed = other.generation() != generation();
+        std::swap(_bytes, other._bytes);
+        std::swap(_segment, other._segment);
+        std::swap(_header, other._header);
+        std::swap(_capacity, other._capacity);
+        return changed;
+    }
+    // count, records published so far
+    inline std::uint64_t count() const noexcept { return _header->head.load(std::memory_order_acquire); }
+    // capacity
+    inline std::size_t capacity() const noexcept { return static_cast<std::size_t>(_capacity); }
+    // read, the record of an index, false once overwritten by the ring or not yet published
+    inline bool read(const std::uint64_t index, StampedPose<qScalar>& out) const noexcept {
+        qScalar arr8[8];
+        if (!_load(index, out.timestamp, arr8)) return false;
+        out.pose = _pose(arr8);
+        return true;
+    }
+    // latest, the last published record, false before the first or when the publisher kept overwriting it
+    inline bool latest(StampedPose<qScalar>& out) const noexcept {
+        for (int attempt=0; attempt<kernel::shm_read_attempts; ++attempt) {
+            const std::uint64_t head = count();
+            if (head == 0) return false;
+            if (read(head - 1, out)) return true;
+        }
+        return false;
+    }
+    // interpolate, the screw motion interpolation at a time between two records still in the ring,
+    // false when the time is outside of them or when the publisher kept overwriting them
+    inline bool interpolate(const double time, Pose<qScalar>& out) const noexcept {
+        for (int attempt=0; attempt<kernel::shm_read_attempts; ++attempt) {
+            const std::uint64_t head = count();
+            if (head == 0) return false;
+            // the oldest slot may be overwritten while reading, skip it
+            std::uint64_t first = head > _capacity ? head - _capacity + 1 : 0;
+            std::uint64_t last = head - 1;
+            double first_time, last_time;
+            qScalar first_pose[8], last_pose[8];
+            if (!_load(last, last_time, last_pose)) continue;
+            if (!_load(first, first_time, first_pose)) continue;
+            if (!(first_time <= time && time <= last_time)) return false;
+            // bisects to neighbouring records first_time <= time <= last_time
+            bool torn = false;
+            while (last - first > 1) {
+                const std::uint64_t middle = first + (last - first) / 2;
+                double middle_time;
+                qScalar middle_pose[8];
+                if (!_load(middle, middle_time, middle_pose)) {
+                    torn = true;
+                    break;
+                }
+                if (middle_time <= time) {
+                    first = middle;
+                    first_time = middle_time;
+                    std::copy(middle_pose, middle_pose + 8, first_pose);
+                } else {
+                    last = middle;
+                    last_time = middle_time;
+                    std::copy(middle_pose, middle_pose + 8, last_pose);
+                }
+            }
+            if (torn) continue;
+            if (time == first_time || !(last_time > first_time)) {
+                out = _pose(first_pose);
+                return true;
+            }
+            cScalar a[8], b[8], res[8];
+            for (int k=0; k<8; ++k) {
+                a[k] = static_cast<cScalar>(first_pose[k]);
+                b[k] = static_cast<cScalar>(last_pose[k]);
+            }
+            kernel::unit_dualquat_interpolate(a, b, static_cast<cScalar>((time - first_time) / (last_time - first_time)), res);
+            out = Pose<qScalar>(static_cast<qScalar>(res[0]), static_cast<qScalar>(res[1]), static_cast<qScalar>(res[2]), static_cast<qScalar>(res[3]),
+                                static_cast<qScalar>(res[4]), static_cast<qScalar>(res[5]), static_cast<qScalar>(res[6]), static_cast<qScalar>(res[7]));
+            return true;
+        }
+        return false;
+    }
+};
+
+using PosePublisherf = PosePublisher<float>;
+using PosePublisherd = PosePublisher<double>;
+using PosePublisherld = PosePublisher<long double>;
+using PoseSubscriberf = PoseSubscriber<float>;
+using PoseSubscriberd = PoseSubscriber<double>;
+using PoseSubscriberld = PoseSubscriber<long double>;
+
+}  // namespace dqpose
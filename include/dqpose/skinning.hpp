@@ -0,0 +1,249 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/skinning.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining dual quaternion linear blending
+ *
+ *     This file provides SkinInfluences, the per-vertex bone indices and
+ *     weights stored one array per influence slot, and skin, which moves
+ *     vertex positions and normals by the normalized weighted sum of their
+ *     bones' unit Dual Quaternions. Every bone of a vertex is flipped onto
+ *     the hemisphere of its first bone before blending, so q and -q act
+ *     alike. Bones are copied once into SoA arrays, vertices are split over
+ *     parallel_for and the inner loop is straight-line arithmetic on SoA
+ *     data, without Dual Quaternion temporaries.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "dualquat.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dqpose
+{
+
+template<QuatScalar qScalar>
+class SkinInfluences {
+protected:
+    // one array per influence slot
+    std::vector<std::vector<std::uint32_t>> _bones;
+    std::vector<std::vector<qScalar>> _weights;
+public:
+    // Default Constructor
+    explicit SkinInfluences(const std::size_t influences=4)
+        : _bones( influences ), _weights( influences ) {
+        if (influences == 0) {
+            throw std::runtime_error("Error: SkinInfluences() Requires at least 1 influence per vertex.");
+        }
+    }
+    // Size Constructor, every influence starts as bone 0 with weight 0
+    explicit SkinInfluences(const std::size_t size, const std::size_t influences)
+        : SkinInfluences( influences ) {
+        resize(size);
+    }
+    // size
+    inline std::size_t size() const noexcept { return _bones[0].size(); }
+    inline std::size_t influences() const noexcept { return _bones.size(); }
+    // resize
+    inline void resize(const std::size_t size) {
+        for (auto& slot : _bones) slot.resize(size, 0);
+        for (auto& slot : _weights) slot.resize(size, 0);
+    }
+    // clear
+    inline void clear() noexcept {
+        for (auto& slot : _bones) slot.clear();
+        for (auto& slot : _weights) slot.clear();
+    }
+    // set, influence k of vertex v
+    inline void set(const std::size_t v, const std::size_t k, const std::uint32_t bone, const qScalar weight) {
+        _bones.at(k).at(v) = bone;
+        _weights[k][v] = weight;
+    }
+    // query
+    inline std::uint32_t bone(const std::size_t v, const std::size_t k) const { return _bones.at(k).at(v); }
+    inline qScalar weight(const std::size_t v, const std::size_t k) const { return _weights.at(k).at(v); }
+    // max_bone, the largest bone index of any slot, weighted or not
+    inline std::uint32_t max_bone() const noexcept {
+        std::uint32_t res = 0;
+        for (const auto& slot : _bones) {
+            for (const std::uint32_t bone : slot) {
+                if (bone > res) res = bone;
+            }
+        }
+        return res;
+    }
+    // normalize, scales the weights of every vertex to sum to 1, vertices without weight are left alone
+    inline void normalize() noexcept {
+        for (std::size_t v=0; v<size(); ++v) {
+            qScalar sum = 0;
+            for (const auto& slot : _weights) sum += slot[v];
+            if (sum == qScalar(0)) continue;
+            for (auto& slot : _weights) slot[v] = slot[v] / sum;
+        }
+    }
+    // data, bone indices and weights of the k-th influence slot
+    inline const std::uint32_t* bones(const std::size_t k) const noexcept { return _bones[k].data(); }
+    inline const qScalar* weights(const std::size_t k) const noexcept { return _weights[k].data(); }
+};
+
+namespace kernel
+{
+
+// dlb_skin, dual quaternion linear blending of vertices [first, last), normals may be null
+template<typename cScalar, typename Scalar>
+inline void dlb_skin(const std::array<const cScalar*, 8>& bones,
+                     const std::uint32_t* const* indices, const Scalar* const* weights, const std::size_t influences,
+                     const std::array<const Scalar*, 3>& positions, const std::array<Scalar*, 3>& out_positions,
+                     const std::array<const Scalar*, 3>& normals, const std::array<Scalar*, 3>& out_normals,
+                     const std::size_t first, const std::size_t last) noexcept {
+    const bool has_normals = normals[0] != nullptr;
+    for (std::size_t v=first; v<last; ++v) {
+        // blend on the hemisphere of the bone of largest weight, slots without weight are skipped
+        std::size_t heaviest = 0;
+        for (std::size_t k=1; k<influences; ++k) {
+            if (weights[k][v] > weights[heaviest][v]) heaviest = k;
+        }
+        const std::uint32_t pivot = indices[heaviest][v];
+        const cScalar pivot_w = bones[0][pivot], pivot_x = bones[1][pivot], pivot_y = bones[2][pivot], pivot_z = bones[3][pivot];
+        cScalar blend[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        for (std::size_t k=0; k<influences; ++k) {
+            const cScalar w = static_cast<cScalar>(weights[k][v]);
+            if (w == cScalar(0)) continue;
+            const std::uint32_t j = indices[k][v];
+            const cScalar dot = pivot_w*bones[0][j] + pivot_x*bones[1][j] + pivot_y*bones[2][j] + pivot_z*bones[3][j];
+            const cScalar signed_w = dot < 0 ? -w : w;
+            for (int c=0; c<8; ++c) blend[c] += signed_w * bones[c][j];
+        }
+        const cScalar norm2 = blend[0]*blend[0] + blend[1]*blend[1] + blend[2]*blend[2] + blend[3]*blend[3];
+        const cScalar p[3] = { static_cast<cScalar>(positions[0][v]), static_cast<cScalar>(positions[1][v]), static_cast<cScalar>(positions[2][v]) };
+        if (!(norm2 > 0)) {
+            // no weight, the vertex stays in place
+            for (int a=0; a<3; ++a) out_positions[a][v] = static_cast<Scalar>(p[a]);
+            if (has_normals) {
+                for (int a=0; a<3; ++a) out_normals[a][v] = normals[a][v];
+            }
+            continue;
+        }
+        const cScalar inv = 1 / std::sqrt(norm2);
+        for (int c=0; c<8; ++c) blend[c] *= inv;
+        cScalar rotated[3], translation[3];
+        quat_rotate(blend, p, rotated);
+        dualquat_translation(blend, translation);
+        for (int a=0; a<3; ++a) out_positions[a][v] = static_cast<Scalar>(rotated[a] + translation[a]);
+        if (has_normals) {
+            const cScalar n[3] = { static_cast<cScalar>(normals[0][v]), static_cast<cScalar>(normals[1][v]), static_cast<cScalar>(normals[2][v]) };
+            quat_rotate(blend, n, rotated);
+            for (int a=0; a<3; ++a) out_normals[a][v] = static_cast<Scalar>(rotated[a]);
+        }
+    }
+}
+
+}  // namespace kernel
+
+// skin, blends positions and, when normals is not null, normals; outputs are resized to the vertex count
+template<typename bScalar, typename Scalar>
+inline void skin(const DualQuatBatch<bScalar>& bones, const SkinInfluences<Scalar>& influences,
+                 const PureQuatBatch<Scalar>& positions, PureQuatBatch<Scalar>& out_positions,
+                 const PureQuatBatch<Scalar>* normals, PureQuatBatch<Scalar>* out_normals, const std::size_t threads=0) {
+    using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+    const std::size_t size = positions.size();
+    if (influences.size() != size || (normals && normals->size() != size)) {
+        throw std::runtime_error("Error: skin() Vertex batches differ in size.");
+    }
+    if (normals && !out_normals) {
+        throw std::runtime_error("Error: skin() Normals given without an output batch.");
+    }
+    if (size == 0) {
+        out_positions.resize(0);
+        if (normals) out_normals->resize(0);
+        return;
+    }
+    if (bones.empty() || influences.max_bone() >= bones.size()) {
+        throw std::runtime_error("Error: skin() Bone index out of range.");
+    }
+    DualQuatBatch<cScalar> bone_data;
+    convert(bones, bone_data);
+    out_positions.resize(size);
+    if (normals) out_normals->resize(size);
+
+    std::array<const cScalar*, 8> bone_arrays;
+    for (int c=0; c<8; ++c) bone_arrays[c] = bone_data.data(c);
+    std::vector<const std::uint32_t*> indices(influences.influences());
+    std::vector<const Scalar*> weights(influences.influences());
+    for (std::size_t k=0; k<influences.influences(); ++k) {
+        indices[k] = influences.bones(k);
+        weights[k] = influences.weights(k);
+    }
+    std::array<const Scalar*, 3> in_p{ }, in_n{ };
+    std::array<Scalar*, 3> out_p{ }, out_n{ };
+    for (int a=0; a<3; ++a) {
+        in_p[a] = positions.data(a);
+        out_p[a] = out_positions.data(a);
+        if (normals) {
+            in_n[a] = normals->data(a);
+            out_n[a] = out_normals->data(a);
+        }
+    }
+    parallel_for(0, size, [&](const std::size_t first, const std::size_t last, std::size_t) {
+        kernel::dlb_skin<cScalar>(bone_arrays, indices.data(), weights.data(), indices.size(),
+                                  in_p, out_p, in_n, out_n, first, last);
+    }, threads, 4096);
+}
+// skin, blends positions
+template<typename bScalar, typename Scalar>
+inline void skin(const DualQuatBatch<bScalar>& bones, const SkinInfluences<Scalar>& influences,
+                 const PureQuatBatch<Scalar>& positions, PureQuatBatch<Scalar>& out_positions, const std::size_t threads=0) {
+    skin(bones, influences, positions, out_positions, static_cast<const PureQuatBatch<Scalar>*>(nullptr),
+         static_cast<PureQuatBatch<Scalar>*>(nullptr), threads);
+}
+// skin, blends positions and normals
+template<typename bScalar, typename Scalar>
+inline void skin(const DualQuatBatch<bScalar>& bones, const SkinInfluences<Scalar>& influences,
+                 const PureQuatBatch<Scalar>& positions, const PureQuatBatch<Scalar>& normals,
+                 PureQuatBatch<Scalar>& out_positions, PureQuatBatch<Scalar>& out_normals, const std::size_t threads=0) {
+    skin(bones, influences, positions, out_positions, &normals, &out_normals, threads);
+}
+// skin, blends positions and normals of UnitDualQuat bones
+template<typename bScalar, typename Scalar>
+inline void skin(const std::vector<UnitDualQuat<bScalar>>& bones, const SkinInfluences<Scalar>& influences,
+                 const PureQuatBatch<Scalar>& positions, const PureQuatBatch<Scalar>& normals,
+                 PureQuatBatch<Scalar>& out_positions, PureQuatBatch<Scalar>& out_normals, const std::size_t threads=0) {
+    DualQuatBatch<bScalar> batch;
+    batch.reserve(bones.size());
+    for (const auto& bone : bones) batch.push_back(bone);
+    skin(batch, influences, positions, out_positions, &normals, &out_normals, threads);
+}
+
+using SkinInfluencesf = SkinInfluences<float>;
+using SkinInfluencesd = SkinInfluences<double>;
+using SkinInfluencesld = SkinInfluences<long double>;
+
+}  // namespace dqpose
@@ -0,0 +1,384 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/spatial.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining a nearest pose index
+ *
+ *     This file provides PoseIndex, a KD-tree over the translations of a
+ *     large set of poses whose nodes also bound the rotations they hold by a
+ *     cone on the unit quaternion hypersphere, an axis and the largest angle
+ *     to it. It answers k-nearest and radius queries under the SE(3)
+ *     distance sqrt(|ta - tb|^2 + (w angle(ra, rb))^2), pruning a node when
+ *     its box distance and the rotation angle left outside its cone already
+ *     exceed the current bound.
+ *
+ *     The tree is implicit: the median splits halve every range, so the
+ *     shape only depends on the size and subtrees are built in parallel. The
+ *     poses are stored by leaf as structure of arrays, so leaves are scanned
+ *     by vectorized loops that leave the acos to the candidates passing the
+ *     translation bound. Batch queries run over parallel_for.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "dualquat.hpp"
+#include "pose.hpp"
+#include "batch.hpp"
+#include "kernel.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dqpose
+{
+
+template<typename qScalar>
+struct PoseIndexOptions {
+    // length units per radian of rotation in the SE(3) distance
+    qScalar rotation_weight = 1;
+    // poses per leaf at most
+    std::size_t leaf_size = 32;
+    // threads of the bulk build and the batch queries, 0 uses every hardware thread
+    std::size_t threads = 0;
+};
+
+// PoseNeighbor, index into the poses the index was built from
+template<typename qScalar>
+struct PoseNeighbor {
+    std::size_t index;
+    qScalar distance;
+};
+
+// pose_distance, sqrt(|ta - tb|^2 + (w angle)^2) between two unit Dual Quaternions, angle the rotation angle of ra* rb
+template<typename qScalar, typename Scalar1, typename Scalar2>
+inline qScalar pose_distance(const DualQuat<Scalar1>& a, const DualQuat<Scalar2>& b, const qScalar rotation_weight) noexcept {
+    const auto arr_a = a.array();
+    const auto arr_b = b.array();
+    qScalar ta[3], tb[3];
+    kernel::dualquat_translation(arr_a.data(), ta);
+    kernel::dualquat_translation(arr_b.data(), tb);
+    qScalar dot = 0, translation2 = 0;
+    for (int k=0; k<4; ++k) dot += static_cast<qScalar>(arr_a[k]) * static_cast<qScalar>(arr_b[k]);
+    for (int k=0; k<3; ++k) translation2 += (ta[k] - tb[k]) * (ta[k] - tb[k]);
+    const qScalar angle = 2 * std::acos(std::min<qScalar>(1, std::abs(dot)));
+    return std::sqrt(translation2 + square(rotation_weight * angle));
+}
+
+template<QuatScalar qScalar>
+class PoseIndex {
+    static_assert(std::is_floating_point_v<qScalar>, "Error: PoseIndex stores float, double or long double.");
+protected:
+    struct _Node {
+        std::array<qScalar, 3> lower, upper;
+        // rotation cone, unit axis and largest angle on the hypersphere to any rotation below, sign free
+        std::array<qScalar, 4> axis;
+        qScalar spread;
+    };
+    struct _Range {
+        std::size_t node, first, count, depth;
+    };
+    // _Query, the query pose and the buffers of one leaf scan
+    struct _Query {
+        qScalar t[3], q[4];
+        std::vector<qScalar> translation2, dot;
+    };
+    PoseIndexOptions<qScalar> _options;
+    std::size_t _depth;
+    std::vector<_Node> _nodes;
+    // x y z of the translations and w x y z of the rotations, in leaf order
+    std::array<std::vector<qScalar>, 7> _data;
+    std::vector<std::size_t> _indices;
+
+    static inline qScalar _angle(const qScalar abs_dot) noexcept {
+        return std::acos(std::min<qScalar>(1, abs_dot));
+    }
+    // _bound, lower bound of the squared distance from the query to any pose below node
+    inline qScalar _bound(const _Node& node, const _Query& query) const noexcept {
+        qScalar translation2 = 0;
+        for (int k=0; k<3; ++k) {
+            const qScalar outside = std::max({ node.lower[k] - query.t[k], query.t[k] - node.upper[k], qScalar(0) });
+            translation2 += outside * outside;
+        }
+        const qScalar dot = node.axis[0]*query.q[0] + node.axis[1]*query.q[1] + node.axis[2]*query.q[2] + node.axis[3]*query.q[3];
+        const qScalar gap = std::max<qScalar>(0, _angle(std::abs(dot)) - node.spread);
+        return translation2 + square(2 * _options.rotation_weight * gap);
+    }
+    // _scan, squared translation distances and absolute rotation dots of a leaf, vectorized
+    inline void _scan(const std::size_t first, const std::size_t count, _Query& query) const noexcept {
+        const qScalar* x = _data[0].data() + first;
+        const qScalar* y = _data[1].data() + first;
+        const qScalar* z = _data[2].data() + first;
+        const qScalar* w = _data[3].data() + first;
+        const qScalar* qx = _data[4].data() + first;
+        const qScalar* qy = _data[5].data() + first;
+        const qScalar* qz = _data[6].data() + first;
+        qScalar* translation2 = query.translation2.data();
+        qScalar* dot = query.dot.data();
+        const qScalar t0 = query.t[0], t1 = query.t[1], t2 = query.t[2];
+        const qScalar q0 = query.q[0], q1 = query.q[1], q2 = query.q[2], q3 = query.q[3];
+        for (std::size_t j=0; j<count; ++j) {
+            translation2[j] = (x[j] - t0) * (x[j] - t0) + (y[j] - t1) * (y[j] - t1) + (z[j] - t2) * (z[j] - t2);
+            dot[j] = std::abs(w[j] * q0 + qx[j] * q1 + qy[j] * q2 + qz[j] * q3);
+        }
+    }
+    // _traverse, visits the leaves in near first order while visit(first, count, bound2) asks for them, bound2 the current pruning radius
+    template<typename Visit, typename Bound>
+    inline void _traverse(_Query& query, Visit&& visit, Bound&& bound2) const {
+        if (_indices.empty()) return;
+        struct Entry { _Range range; qScalar lower; };
+        std::vector<Entry> stack;
+        stack.reserve(2 * _depth + 2);
+        stack.push_back({ { 0, 0, _indices.size(), 0 }, _bound(_nodes[0], query) });
+        while (!stack.empty()) {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            if (entry.range.count == 0 || entry.lower > bound2()) continue;
+            if (entry.range.depth == _depth) {
+                _scan(entry.range.first, entry.range.count, query);
+                visit(entry.range.first, entry.range.count);
+                continue;
+            }
+            const std::size_t half = entry.range.count / 2;
+            const _Range left{ 2 * entry.range.node + 1, entry.range.first, half, entry.range.depth + 1 };
+            const _Range right{ 2 * entry.range.node + 2, entry.range.first + half, entry.range.count - half, entry.range.depth + 1 };
+            const qScalar left_lower = left.count ? _bound(_nodes[left.node], query) : std::numeric_limits<qScalar>::infinity();
+            const qScalar right_lower = right.count ? _bound(_nodes[right.node], query) : std::numeric_limits<qScalar>::infinity();
+            if (left_lower <= right_lower) {
+                stack.push_back({ right, right_lower });
+                stack.push_back({ left, left_lower });
+            } else {
+                stack.push_back({ left, left_lower });
+                stack.push_back({ right, right_lower });
+            }
+        }
+    }
+    template<typename Scalar>
+    inline _Query _query(const DualQuat<Scalar>& pose) const {
+        const auto arr = pose.array();
+        _Query query;
+        kernel::dualquat_translation(arr.data(), query.t);
+        for (int k=0; k<4; ++k) query.q[k] = static_cast<qScalar>(arr[k]);
+        query.translation2.resize(std::max<std::size_t>(1, _options.leaf_size));
+        query.dot.resize(std::max<std::size_t>(1, _options.leaf_size));
+        return query;
+    }
+    inline void _knn(_Query& query, const std::size_t k, std::vector<PoseNeighbor<qScalar>>& out) const {
+        // max heap of squared distances and slots
+        std::vector<std::pair<qScalar, std::size_t>> heap;
+        heap.reserve(k + 1);
+        const qScalar weight2 = square(2 * _options.rotation_weight);
+        const auto worst = [&]() {
+            return heap.size() < k ? std::numeric_limits<qScalar>::infinity() : heap.front().first;
+        };
+        _traverse(query, [&](const std::size_t first, const std::size_t count) {
+            for (std::size_t j=0; j<count; ++j) {
+                if (!(query.translation2[j] < worst())) continue;
+                const qScalar distance2 = query.translation2[j] + weight2 * square(_angle(query.dot[j]));
+                if (!(distance2 < worst())) continue;
+                heap.emplace_back(distance2, first + j);
+                std::push_heap(heap.begin(), heap.end());
+                if (heap.size() > k) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.pop_back();
+                }
+            }
+        }, worst);
+        std::sort_heap(heap.begin(), heap.end());
+        out.clear();
+        for (const auto& [distance2, slot] : heap) out.push_back({ _indices[slot], std::sqrt(distance2) });
+    }
+    // _build, the statistics of a node and the median split of its range
+    inline void _build(const _Range& range, std::vector<std::size_t>& order, const std::vector<std::array<qScalar, 7>>& poses) {
+        _Node& node = _nodes[range.node];
+        node.lower.fill(std::numeric_limits<qScalar>::infinity());
+        node.upper.fill(-std::numeric_limits<qScalar>::infinity());
+        node.axis = { 1, 0, 0, 0 };
+        node.spread = 0;
+        if (range.count == 0) return;
+        const std::size_t* members = order.data() + range.first;
+        std::array<qScalar, 4> sum{ };
+        const std::array<qScalar, 7>& reference = poses[members[0]];
+        for (std::size_t i=0; i<range.count; ++i) {
+            const std::array<qScalar, 7>& pose = poses[members[i]];
+            for (int k=0; k<3; ++k) {
+                node.lower[k] = std::min(node.lower[k], pose[k]);
+                node.upper[k] = std::max(node.upper[k], pose[k]);
+            }
+            // rotations summed on the hemisphere of the first one
+            const qScalar sign = reference[3]*pose[3] + reference[4]*pose[4] + reference[5]*pose[5] + reference[6]*pose[6] < 0 ? -1 : 1;
+            for (int k=0; k<4; ++k) sum[k] += sign * pose[k+3];
+        }
+        const qScalar norm = std::sqrt(sum[0]*sum[0] + sum[1]*sum[1] + sum[2]*sum[2] + sum[3]*sum[3]);
+        for (int k=0; k<4; ++k) node.axis[k] = norm > 0 ? sum[k] / norm : reference[k+3];
+        for (std::size_t i=0; i<range.count; ++i) {
+            const std::array<qScalar, 7>& pose = poses[members[i]];
+            const qScalar dot = node.axis[0]*pose[3] + node.axis[1]*pose[4] + node.axis[2]*pose[5] + node.axis[3]*pose[6];
+            node.spread = std::max(node.spread, _angle(std::abs(dot)));
+        }
+        // acos near 1 amplifies the rounding of the dots to about sqrt(epsilon), widen the cone past it
+        node.spread += 4 * std::sqrt(std::numeric_limits<qScalar>::epsilon());
+        if (range.depth == _depth) return;
+        int split = 0;
+        for (int k=1; k<3; ++k) {
+            if (node.upper[k] - node.lower[k] > node.upper[split] - node.lower[split]) split = k;
+        }
+        std::nth_element(order.begin() + range.first, order.begin() + range.first + range.count / 2, order.begin() + range.first + range.count,
+                         [&](const std::size_t a, const std::size_t b) { return poses[a][split] < poses[b][split]; });
+    }
+    inline void _build_subtree(const _Range& root, std::vector<std::size_t>& order, const std::vector<std::array<qScalar, 7>>& poses) {
+        std::vector<_Range> stack{ root };
+        while (!stack.empty()) {
+            const _Range range = stack.back();
+            stack.pop_back();
+            _build(range, order, poses);
+            if (range.depth == _depth) continue;
+            const std::size_t half = range.count / 2;
+            stack.push_back({ 2 * range.node + 1, range.first, half, range.depth + 1 });
+            stack.push_back({ 2 * range.node + 2, range.first + half, range.count - half, range.depth + 1 });
+        }
+    }
+    inline void _build_all(const std::vector<std::array<qScalar, 7>>& poses) {
+        if (_options.leaf_size == 0) {
+            throw std::runtime_error("Error: PoseIndex() Leaf size must be positive.");
+        }
+        const std::size_t size = poses.size();
+        _depth = 0;
+        while (_options.leaf_size << _depth < size) ++_depth;
+        _nodes.assign((std::size_t(2) << _depth) - 1, _Node{ });
+        std::vector<std::size_t> order(size);
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        // split the top levels serially until every thread has subtrees to build
+        const std::size_t threads = parallel_chunks(0, size, _options.threads, 4096);
+        std::vector<_Range> subtrees{ { 0, 0, size, 0 } };
+        while (threads > 1 && subtrees.size() < 4 * threads && subtrees.front().depth < _depth) {
+            std::vector<_Range> next;
+            for (const _Range& range : subtrees) {
+                _build(range, order, poses);
+                const std::size_t half = range.count / 2;
+                next.push_back({ 2 * range.node + 1, range.first, half, range.depth + 1 });
+                next.push_back({ 2 * range.node + 2, range.first + half, range.count - half, range.depth + 1 });
+            }
+            subtrees.swap(next);
+        }
+        parallel_for(0, subtrees.size(), [&](const std::size_t first, const std::size_t last, std::size_t) {
+            for (std::size_t s=first; s<last; ++s) _build_subtree(subtrees[s], order, poses);
+        }, threads, 1);
+        for (auto& column : _data) column.resize(size);
+        parallel_for(0, size, [&](const std::size_t first, const std::size_t last, std::size_t) {
+            for (std::size_t i=first; i<last; ++i) {
+                for (int k=0; k<7; ++k) _data[k][i] = poses[order[i]][k];
+            }
+        }, threads, 65536);
+        _indices = std::move(order);
+    }
+    template<typename Scalar>
+    static inline std::array<qScalar, 7> _compact(const Scalar* dq) noexcept {
+        std::array<qScalar, 7> pose;
+        kernel::dualquat_translation(dq, pose.data());
+        for (int k=0; k<4; ++k) pose[k+3] = static_cast<qScalar>(dq[k]);
+        return pose;
+    }
+public:
+    // Batch Constructor, indexes unit Dual Quaternions
+    template<typename Scalar>
+    explicit PoseIndex(const DualQuatBatch<Scalar>& poses, const PoseIndexOptions<qScalar>& options=PoseIndexOptions<qScalar>())
+        : _options( options ), _depth( 0 ) {
+        using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+        std::vector<std::array<qScalar, 7>> compact(poses.size());
+        parallel_for(0, poses.size(), [&](const std::size_t first, const std::size_t last, std::size_t) {
+            for (std::size_t i=first; i<last; ++i) {
+                cScalar dq[8];
+                poses.load(i, dq);
+                compact[i] = _compact(dq);
+            }
+        }, _options.threads, 65536);
+        _build_all(compact);
+    }
+    // Vector Constructor
+    template<typename Scalar>
+    explicit PoseIndex(const std::vector<Pose<Scalar>>& poses, const PoseIndexOptions<qScalar>& options=PoseIndexOptions<qScalar>())
+        : _options( options ), _depth( 0 ) {
+        std::vector<std::array<qScalar, 7>> compact(poses.size());
+        for (std::size_t i=0; i<poses.size(); ++i) compact[i] = _compact(poses[i].array().data());
+        _build_all(compact);
+    }
+    // size
+    inline std::size_t size() const noexcept { return _indices.size(); }
+    // options
+    inline const PoseIndexOptions<qScalar>& options() const noexcept { return _options; }
+    // knn, the k nearest poses by increasing distance, fewer when the index holds fewer
+    template<typename Scalar>
+    inline std::vector<PoseNeighbor<qScalar>> knn(const DualQuat<Scalar>& query, const std::size_t k) const {
+        _Query q = _query(query);
+        std::vector<PoseNeighbor<qScalar>> res;
+        if (k != 0) _knn(q, k, res);
+        return res;
+    }
+    // knn, the k nearest poses of every query, query i filling out[i*k, i*k + k), by increasing distance;
+    // when the index holds fewer than k poses the rest have index size() and an infinite distance
+    template<typename Scalar>
+    inline void knn(const DualQuatBatch<Scalar>& queries, const std::size_t k, std::vector<PoseNeighbor<qScalar>>& out) const {
+        using cScalar = std::conditional_t<std::is_floating_point_v<Scalar>, Scalar, float>;
+        out.assign(queries.size() * k, PoseNeighbor<qScalar>{ size(), std::numeric_limits<qScalar>::infinity() });
+        if (k == 0) return;
+        parallel_for(0, queries.size(), [&](const std::size_t first, const std::size_t last, std::size_t) {
+            std::vector<PoseNeighbor<qScalar>> found;
+            for (std::size_t i=first; i<last; ++i) {
+                cScalar arr[8];
+                queries.load(i, arr);
+                _Query q = _query(DualQuat<cScalar>(arr[0], arr[1], arr[2], arr[3], arr[4], arr[5], arr[6], arr[7]));
+                _knn(q, k, found);
+                std::copy(found.begin(), found.end(), out.begin() + i * k);
+            }
+        }, _options.threads, 64);
+    }
+    // radius, every pose within the distance by increasing distance
+    template<typename Scalar>
+    inline std::vector<PoseNeighbor<qScalar>> radius(const DualQuat<Scalar>& query, const qScalar distance) const {
+        _Query q = _query(query);
+        const qScalar radius2 = distance * distance;
+        const qScalar weight2 = square(2 * _options.rotation_weight);
+        std::vector<PoseNeighbor<qScalar>> res;
+        _traverse(q, [&](const std::size_t first, const std::size_t count) {
+            for (std::size_t j=0; j<count; ++j) {
+                if (!(q.translation2[j] <= radius2)) continue;
+                const qScalar distance2 = q.translation2[j] + weight2 * square(_angle(q.dot[j]));
+                if (distance2 <= radius2) res.push_back({ _indices[first + j], std::sqrt(distance2) });
+            }
+        }, [&]() { return radius2; });
+        std::sort(res.begin(), res.end(), [](const PoseNeighbor<qScalar>& a, const PoseNeighbor<qScalar>& b) { return a.distance < b.distance; });
+        return res;
+    }
+};
+
+using PoseIndexf = PoseIndex<float>;
+using PoseIndexd = PoseIndex<double>;
+using PoseIndexld = PoseIndex<long double>;
+
+}  // namespace dqpose
@@ -0,0 +1,449 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/stream.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining streaming trajectory readers and writers
+ *
+ *     This file provides PoseReader and PoseWriter, which stream timestamped
+ *     Poses through a binary log without holding it in memory. A log is a
+ *     16 byte header, the magic "DQPOSE01" then the scalar size, followed
+ *     by records of one double timestamp and the 8 scalars of the Pose.
+ *     Records read back bit exact: the reader does not renormalize them,
+ *     a log of drifted poses is projected back by normalize if needed.
+ *
+ *     Both sides own two chunks of records and one background thread: the
+ *     reader fills one chunk from disk while the caller decodes the other,
+ *     the writer drains one chunk to disk while the caller fills the other.
+ *     The stdio buffer is disabled since the chunks already batch the
+ *     system calls. On POSIX systems the reader hints sequential access and
+ *     asks the kernel to read ahead the chunk after the one just loaded.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "pose.hpp"
+#include "batch.hpp"
+#include "trace_macros.hpp"
+#include <array>
+#include <vector>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#endif
+
+namespace dqpose
+{
+
+struct StreamOptions {
+    // records per chunk, two chunks are kept in memory
+    std::size_t chunk_records = 65536;
+    // access pattern hints to the kernel, where supported
+    bool access_hints = true;
+};
+
+template<QuatScalar qScalar>
+struct StampedPose {
+    double timestamp = 0;
+    Pose<qScalar> pose;
+};
+
+namespace kernel
+{
+
+inline constexpr char stream_magic[8] = { 'D', 'Q', 'P', 'O', 'S', 'E', '0', '1' };
+inline constexpr std::size_t stream_header_bytes = 16;
+
+// stream_record_bytes, bytes of one timestamped record
+template<typename qScalar>
+constexpr inline std::size_t stream_record_bytes() noexcept {
+    return sizeof(double) + 8 * sizeof(qScalar);
+}
+
+// stream_advise, hints the kernel that [offset, offset + bytes) of the file will be needed, bytes = 0 hints sequential access of the whole file
+inline void stream_advise(std::FILE* file, const std::uint64_t offset, const std::uint64_t bytes) noexcept {
+#if defined(POSIX_FADV_SEQUENTIAL) && defined(POSIX_FADV_WILLNEED)
+    const int advice = bytes == 0 ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_WILLNEED;
+    ::posix_fadvise(fileno(file), static_cast<off_t>(offset), static_cast<off_t>(bytes), advice);
+#else
+    (void)file; (void)offset; (void)bytes;
+#endif
+}
+
+}  // namespace kernel
+
+template<QuatScalar qScalar>
+class PoseReader {
+protected:
+    struct _Chunk {
+        std::vector<unsigned char> bytes;
+        std::size_t records = 0;
+        bool ready = false;
+        bool last = false;
+    };
+    std::FILE* _file;
+    StreamOptions _options;
+    std::array<_Chunk, 2> _chunks;
+    std::size_t _current = 0;
+    std::size_t _position = 0;
+    bool _held = false;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _stop = false;
+    std::exception_ptr _error;
+    std::thread _thread;
+
+    // _load, background thread, fills the chunks in turn until the end of the file
+    inline void _load() noexcept {
+        constexpr std::size_t record_bytes = kernel::stream_record_bytes<qScalar>();
+        std::uint64_t offset = kernel::stream_header_bytes;
+        const std::uint64_t chunk_bytes = _options.chunk_records * record_bytes;
+        for (std::size_t k=0;; k^=1) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait(lock, [&]{ return _stop || !_chunks[k].ready; });
+                if (_stop) return;
+            }
+            DQPOSE_TRACE_SCOPE("dqpose::PoseReader::load");
+            _Chunk& chunk = _chunks[k];
+            const std::size_t got = std::fread(chunk.bytes.data(), 1, chunk_bytes, _file);
+            offset += got;
+            const bool last = got < chunk_bytes;
+            if (!last && _options.access_hints) {
+                kernel::stream_advise(_file, offset, chunk_bytes);
+            }
+            std::exception_ptr error;
+            if (last && std::ferror(_file)) {
+                error = std::make_exception_ptr(std::runtime_error("Error: PoseReader() Failed reading the log."));
+            } else if (got % record_bytes != 0) {
+                error = std::make_exception_ptr(std::runtime_error("Error: PoseReader() Truncated record at the end of the log."));
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _error = error;
+                chunk.records = got / record_bytes;
+                chunk.last = last || error;
+                chunk.ready = true;
+            }
+            _cv.notify_all();
+            if (last || error) return;
+        }
+    }
+    // _decode, one record, the scalars as they were written, not renormalized
+    static inline void _decode(const unsigned char* record, StampedPose<qScalar>& out) noexcept {
+        qScalar arr8[8];
+        std::memcpy(&out.timestamp, record, sizeof(double));
+        std::memcpy(arr8, record + sizeof(double), sizeof(arr8));
+        out.pose = Pose<qScalar>(unnormalized, arr8[0], arr8[1], arr8[2], arr8[3], arr8[4], arr8[5], arr8[6], arr8[7]);
+    }
+    // _acquire, a chunk with records left to decode, null at the end of the log
+    inline const _Chunk* _acquire() {
+        while (true) {
+            if (!_held) {
+                DQPOSE_TRACE_SCOPE("dqpose::PoseReader::wait");
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait(lock, [&]{ return _chunks[_current].ready; });
+                if (_error) std::rethrow_exception(_error);
+                _held = true;
+                _position = 0;
+            }
+            const _Chunk& chunk = _chunks[_current];
+            if (_position < chunk.records) return &chunk;
+            if (chunk.last) return nullptr;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _chunks[_current].ready = false;
+            }
+            _cv.notify_all();
+            _current ^= 1;
+            _held = false;
+        }
+    }
+public:
+    class iterator {
+    protected:
+        PoseReader* _reader;
+        StampedPose<qScalar> _value;
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = StampedPose<qScalar>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const StampedPose<qScalar>*;
+        using reference = const StampedPose<qScalar>&;
+
+        explicit iterator(PoseReader* reader=nullptr) : _reader( reader ) { }
+        inline reference operator*() const noexcept { return _value; }
+        inline pointer operator->() const noexcept { return &_value; }
+        inline iterator& operator++() {
+            if (!_reader->next(_value)) _reader = nullptr;
+            return *this;
+        }
+        inline void operator++(int) { ++*this; }
+        inline bool operator==(const iterator& other) const noexcept { return _reader == other._reader; }
+    };
+
+    // Path Constructor, starts reading ahead in the background
+    explicit PoseReader(const std::string& path, const StreamOptions& options=StreamOptions())
+        : _file( std::fopen(path.c_str(), "rb") ), _options( options ) {
+        if (!_file) {
+            throw std::runtime_error("Error: PoseReader() Failed opening " + path + ".");
+        }
+        if (_options.chunk_records == 0) _options.chunk_records = 1;
+        std::setvbuf(_file, nullptr, _IONBF, 0);
+        unsigned char header[kernel::stream_header_bytes];
+        std::uint32_t scalar_bytes = 0;
+        if (std::fread(header, 1, sizeof(header), _file) != sizeof(header) ||
+            std::memcmp(header, kernel::stream_magic, sizeof(kernel::stream_magic)) != 0) {
+            std::fclose(_file);
+            throw std::runtime_error("Error: PoseReader() " + path + " is not a pose log.");
+        }
+        std::memcpy(&scalar_bytes, header + 8, sizeof(scalar_bytes));
+        if (scalar_bytes != sizeof(qScalar)) {
+            std::fclose(_file);
+            throw std::runtime_error("Error: PoseReader() " + path + " holds scalars of another size.");
+        }
+        if (_options.access_hints) {
+            kernel::stream_advise(_file, 0, 0);
+        }
+        for (auto& chunk : _chunks) chunk.bytes.resize(_options.chunk_records * kernel::stream_record_bytes<qScalar>());
+        _thread = std::thread(&PoseReader::_load, this);
+    }
+    PoseReader(const PoseReader&)=delete;
+    PoseReader& operator=(const PoseReader&)=delete;
+    // Destructor
+    virtual ~PoseReader() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        if (_thread.joinable()) _thread.join();
+        std::fclose(_file);
+    }
+    // next, the next record, false at the end of the log
+    inline bool next(StampedPose<qScalar>& out) {
+        const _Chunk* chunk = _acquire();
+        if (!chunk) return false;
+        _decode(chunk->bytes.data() + _position * kernel::stream_record_bytes<qScalar>(), out);
+        ++_position;
+        return true;
+    }
+    // read, appends up to max records, returns the number appended, 0 at the end of the log
+    inline std::size_t read(std::vector<double>& timestamps, DualQuatBatch<qScalar>& poses, const std::size_t max) {
+        DQPOSE_TRACE_SCOPE("dqpose::PoseReader::read");
+        constexpr std::size_t record_bytes = kernel::stream_record_bytes<qScalar>();
+        std::size_t count = 0;
+        while (count < max) {
+            const _Chunk* chunk = _acquire();
+            if (!chunk) break;
+            const std::size_t take = std::min(max - count, chunk->records - _position);
+            const std::size_t offset = poses.size();
+            timestamps.resize(offset + take);
+            poses.resize(offset + take);
+            const unsigned char* record = chunk->bytes.data() + _position * record_bytes;
+            for (std::size_t i=0; i<take; ++i, record+=record_bytes) {
+                qScalar arr8[8];
+                std::memcpy(&timestamps[offset + i], record, sizeof(double));
+                std::memcpy(arr8, record + sizeof(double), sizeof(arr8));
+                poses.store(offset + i, arr8);
+            }
+            _position += take;
+            count += take;
+        }
+        return count;
+    }
+    // iteration, single pass
+    inline iterator begin() { return ++iterator(this); }
+    inline iterator end() noexcept { return iterator(); }
+};
+
+template<QuatScalar qScalar>
+class PoseWriter {
+protected:
+    struct _Chunk {
+        std::vector<unsigned char> bytes;
+        std::size_t records = 0;
+        bool ready = false;
+    };
+    std::FILE* _file;
+    StreamOptions _options;
+    std::array<_Chunk, 2> _chunks;
+    std::size_t _current = 0;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _stop = false;
+    std::exception_ptr _error;
+    std::thread _thread;
+
+    // _store, background thread, drains the submitted chunks in turn
+    inline void _store() noexcept {
+        constexpr std::size_t record_bytes = kernel::stream_record_bytes<qScalar>();
+        for (std::size_t k=0;; k^=1) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait(lock, [&]{ return _stop || _chunks[k].ready; });
+                if (!_chunks[k].ready) return;
+            }
+            _Chunk& chunk = _chunks[k];
+            const std::size_t bytes = chunk.records * record_bytes;
+            const bool failed = std::fwrite(chunk.bytes.data(), 1, bytes, _file) != bytes;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (failed && !_error) {
+                    _error = std::make_exception_ptr(std::runtime_error("Error: PoseWriter() Failed writing the log."));
+                }
+                chunk.records = 0;
+                chunk.ready = false;
+            }
+            _cv.notify_all();
+        }
+    }
+    // _submit, hands the current chunk to the background thread and waits for the other one to be free
+    inline void _submit() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _chunks[_current].ready = true;
+        }
+        _cv.notify_all();
+        _current ^= 1;
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [&]{ return !_chunks[_current].ready; });
+        if (_error) std::rethrow_exception(_error);
+    }
+    // _append, one record, submits the current chunk when full
+    inline void _append(const double timestamp, const qScalar* arr8) {
+        constexpr std::size_t record_bytes = kernel::stream_record_bytes<qScalar>();
+        _Chunk& chunk = _chunks[_current];
+        unsigned char* record = chunk.bytes.data() + chunk.records * record_bytes;
+        std::memcpy(record, &timestamp, sizeof(double));
+        std::memcpy(record + sizeof(double), arr8, 8 * sizeof(qScalar));
+        if (++chunk.records == _options.chunk_records) _submit();
+    }
+public:
+    // Path Constructor, truncates the file and writes the header
+    explicit PoseWriter(const std::string& path, const StreamOptions& options=StreamOptions())
+        : _file( std::fopen(path.c_str(), "wb") ), _options( options ) {
+        if (!_file) {
+            throw std::runtime_error("Error: PoseWriter() Failed opening " + path + ".");
+        }
+        if (_options.chunk_records == 0) _options.chunk_records = 1;
+        std::setvbuf(_file, nullptr, _IONBF, 0);
+        unsigned char header[kernel::stream_header_bytes] = { };
+        const std::uint32_t scalar_bytes = sizeof(qScalar);
+        std::memcpy(header, kernel::stream_magic, sizeof(kernel::stream_magic));
+        std::memcpy(header + 8, &scalar_bytes, sizeof(scalar_bytes));
+        if (std::fwrite(header, 1, sizeof(header), _file) != sizeof(header)) {
+            std::fclose(_file);
+            throw std::runtime_error("Error: PoseWriter() Failed writing the header of " + path + ".");
+        }
+        for (auto& chunk : _chunks) chunk.bytes.resize(_options.chunk_records * kernel::stream_record_bytes<qScalar>());
+        _thread = std::thread(&PoseWriter::_store, this);
+    }
+    PoseWriter(const PoseWriter&)=delete;
+    PoseWriter& operator=(const PoseWriter&)=delete;
+    // Destructor, closes the log, errors are dropped, call close() to see them
+    virtual ~PoseWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+    // write, one record, returns once it is buffered
+    template<typename Scalar>
+    inline void write(const double timestamp, const DualQuat<Scalar>& pose) {
+        if (!_file) {
+            throw std::runtime_error("Error: PoseWriter::write() The log is closed.");
+        }
+        const Quat<Scalar> real = pose.real();
+        const Quat<Scalar> dual = pose.dual();
+        const qScalar arr8[8] = { static_cast<qScalar>(real.w()), static_cast<qScalar>(real.x()), static_cast<qScalar>(real.y()), static_cast<qScalar>(real.z()),
+                                  static_cast<qScalar>(dual.w()), static_cast<qScalar>(dual.x()), static_cast<qScalar>(dual.y()), static_cast<qScalar>(dual.z()) };
+        _append(timestamp, arr8);
+    }
+    // write, one record
+    inline void write(const StampedPose<qScalar>& record) {
+        write(record.timestamp, record.pose);
+    }
+    // write, a batch of records
+    inline void write(const double* timestamps, const DualQuatBatch<qScalar>& poses) {
+        if (!_file) {
+            throw std::runtime_error("Error: PoseWriter::write() The log is closed.");
+        }
+        for (std::size_t i=0; i<poses.size(); ++i) {
+            qScalar arr8[8];
+            poses.load(i, arr8);
+            _append(timestamps[i], arr8);
+        }
+    }
+    // flush, waits until every buffered record reached the file
+    inline void flush() {
+        if (!_file) return;
+        if (_chunks[_current].records > 0) _submit();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [&]{ return !_chunks[0].ready && !_chunks[1].ready; });
+        if (_error) std::rethrow_exception(_error);
+    }
+    // close, flushes and closes the log, further writes throw
+    inline void close() {
+        if (!_file) return;
+        std::exception_ptr error;
+        try {
+            flush();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        _thread.join();
+        const bool failed = std::fclose(_file) != 0;
+        _file = nullptr;
+        if (error) std::rethrow_exception(error);
+        if (failed) {
+            throw std::runtime_error("Error: PoseWriter::close() Failed closing the log.");
+        }
+    }
+};
+
+using StampedPosef = StampedPose<float>;
+using StampedPosed = StampedPose<double>;
+using StampedPoseld = StampedPose<long double>;
+using PoseReaderf = PoseReader<float>;
+using PoseReaderd = PoseReader<double>;
+using PoseReaderld = PoseReader<long double>;
+using PoseWriterf = PoseWriter<float>;
+using PoseWriterd = PoseWriter<double>;
+using PoseWriterld = PoseWriter<long double>;
+
+}  // namespace dqpose
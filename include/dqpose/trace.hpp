@@ -0,0 +1,419 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/trace.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining scoped tracing of the library entry points
+ *
+ *     This file provides the spans the library emits around its entry points:
+ *     chain composition, batch transforms and screw log/exp, interpolation by
+ *     pow, log reads and the dispatched kernels. Spans are only compiled in
+ *     when DQPOSE_TRACE is defined, which must then hold for every translation
+ *     unit of the program, see dqpose_TRACE in CMakeLists.txt. The library
+ *     headers only include trace_macros.hpp, which pulls this file in under
+ *     DQPOSE_TRACE and otherwise defines DQPOSE_TRACE_SCOPE to nothing.
+ *
+ *     A span takes two time stamp counter reads, steady_clock off x86, and
+ *     while recording is started lands in a ring buffer owned by its thread,
+ *     written without locks. Every operation also keeps a log-linear latency
+ *     histogram, 32 sub-buckets per power of 2, so about 3% resolution, of
+ *     relaxed atomic counters. Spans export to the Chrome trace JSON format,
+ *     which Perfetto reads, and histograms to per operation percentiles.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define DQPOSE_TRACE_TSC 1
+#endif
+
+namespace dqpose
+{
+
+namespace trace
+{
+
+struct TraceOptions {
+    // spans kept per thread, older ones are overwritten
+    std::size_t span_capacity = 65536;
+    // record spans for export, histograms are always kept while started
+    bool spans = true;
+};
+
+// OperationSummary, latencies in nanoseconds
+struct OperationSummary {
+    std::string name;
+    std::uint64_t count;
+    double p50;
+    double p99;
+    double p999;
+    double max;
+};
+
+// max_operations, distinct traced operations, later ones are ignored
+inline constexpr std::size_t max_operations = 256;
+
+// ticks, the time stamp counter or steady_clock nanoseconds
+inline std::uint64_t ticks() noexcept {
+#ifdef DQPOSE_TRACE_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Histogram, log-linear buckets of tick counts, lock free
+class Histogram {
+public:
+    static constexpr int sub_bits = 5;
+    static constexpr std::size_t sub_count = std::size_t(1) << sub_bits;
+    static constexpr std::size_t bucket_count = sub_count + (64 - sub_bits) * sub_count;
+protected:
+    std::array<std::atomic<std::uint64_t>, bucket_count> _counts{ };
+    std::atomic<std::uint64_t> _max{ 0 };
+public:
+    // bucket, exact below sub_count, then sub_count buckets per power of 2
+    static constexpr std::size_t bucket(const std::uint64_t value) noexcept {
+        if (value < sub_count) return static_cast<std::size_t>(value);
+        const int magnitude = std::bit_width(value) - 1;
+        const std::size_t sub = static_cast<std::size_t>(value >> (magnitude - sub_bits)) - sub_count;
+        return sub_count + static_cast<std::size_t>(magnitude - sub_bits) * sub_count + sub;
+    }
+    // midpoint, of the values falling in the bucket
+    static constexpr double midpoint(const std::size_t index) noexcept {
+        if (index < sub_count) return static_cast<double>(index);
+        const std::size_t shift = (index - sub_count) / sub_count;
+        const std::size_t sub = (index - sub_count) % sub_count;
+        const double low = static_cast<double>((sub_count + sub) << shift);
+        return low + static_cast<double>(std::uint64_t(1) << shift) / 2;
+    }
+    // add
+    inline void add(const std::uint64_t value) noexcept {
+        _counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+    }
+    // count
+    inline std::uint64_t count() const noexcept {
+        std::uint64_t total = 0;
+        for (const auto& c : _counts) total += c.load(std::memory_order_relaxed);
+        return total;
+    }
+    // max
+    inline std::uint64_t max() const noexcept { return _max.load(std::memory_order_relaxed); }
+    // percentile, p in [0, 1], in ticks, 0 when empty
+    inline double percentile(const double p) const noexcept {
+        const std::uint64_t total = count();
+        if (total == 0) return 0;
+        const std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(total - 1));
+        std::uint64_t seen = 0;
+        for (std::size_t i=0; i<bucket_count; ++i) {
+            seen += _counts[i].load(std::memory_order_relaxed);
+            if (seen > rank) return std::min(midpoint(i), static_cast<double>(max()));
+        }
+        return static_cast<double>(max());
+    }
+    // clear
+    inline void clear() noexcept {
+        for (auto& c : _counts) c.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+};
+
+namespace detail
+{
+
+struct Span {
+    std::atomic<std::uint64_t> begin{ 0 };
+    std::atomic<std::uint64_t> end{ 0 };
+    std::atomic<std::uint32_t> operation{ 0 };
+};
+
+// ThreadBuffer, single producer ring of spans, kept after its thread exits until its spans are exported or cleared
+struct ThreadBuffer {
+    std::uint32_t thread;
+    std::vector<Span> spans;
+    std::atomic<std::uint64_t> head{ 0 };
+    std::atomic<std::uint64_t> floor{ 0 };
+    // retired, its thread has exited and its spans are not yet consumed, guarded by State::mutex
+    bool retired = false;
+    ThreadBuffer(const std::uint32_t id, const std::size_t capacity) : thread( id ), spans( capacity ) { }
+};
+
+struct State {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::array<std::unique_ptr<Histogram>, max_operations> histograms;
+    std::atomic<std::size_t> operation_count{ 0 };
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    // free, buffers of exited threads whose spans were consumed, reused by new threads
+    std::vector<ThreadBuffer*> free;
+    std::uint32_t thread_count = 0;
+    std::atomic<bool> recording{ false };
+    std::atomic<bool> spans{ true };
+    std::atomic<std::size_t> span_capacity{ 65536 };
+    // time stamp counter and steady_clock at start, for the conversion to nanoseconds
+    std::uint64_t origin_ticks = 0;
+    std::chrono::steady_clock::time_point origin_time;
+};
+
+inline State& state() {
+    static State instance;
+    return instance;
+}
+
+// recycle, moves the retired buffers whose spans were consumed to the free list, with the mutex held
+inline void recycle(State& s) {
+    for (auto& buffer : s.buffers) {
+        if (buffer->retired && buffer->floor.load() >= buffer->head.load(std::memory_order_acquire)) {
+            buffer->retired = false;
+            s.free.push_back(buffer.get());
+        }
+    }
+}
+
+// ThreadOwner, retires the buffer of its thread on exit, the main thread's is destroyed before the static State
+struct ThreadOwner {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadOwner() {
+        if (!buffer) return;
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        buffer->retired = true;
+        recycle(s);
+    }
+};
+
+inline ThreadBuffer* thread_buffer() {
+    thread_local ThreadOwner owner;
+    if (!owner.buffer) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const std::size_t capacity = std::max<std::size_t>(1, s.span_capacity.load());
+        if (s.free.empty()) {
+            s.buffers.push_back(std::make_unique<ThreadBuffer>(s.thread_count, capacity));
+            owner.buffer = s.buffers.back().get();
+        } else {
+            ThreadBuffer* buffer = s.free.back();
+            if (buffer->spans.size() != capacity) std::vector<Span>(capacity).swap(buffer->spans);
+            s.free.pop_back();
+            buffer->thread = s.thread_count;
+            buffer->head.store(0);
+            buffer->floor.store(0);
+            owner.buffer = buffer;
+        }
+        ++s.thread_count;
+    }
+    return owner.buffer;
+}
+
+}  // namespace detail
+
+// operation, the id of a named operation, registered on first use, names are compared by content
+inline std::uint32_t operation(const char* name) {
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (std::size_t i=0; i<s.names.size(); ++i) {
+        if (s.names[i] == name) return static_cast<std::uint32_t>(i);
+    }
+    if (s.names.size() == max_operations) return static_cast<std::uint32_t>(max_operations);
+    s.names.emplace_back(name);
+    s.histograms[s.names.size() - 1] = std::make_unique<Histogram>();
+    s.operation_count.store(s.names.size(), std::memory_order_release);
+    return static_cast<std::uint32_t>(s.names.size() - 1);
+}
+
+// recording
+inline bool recording() noexcept { return detail::state().recording.load(std::memory_order_relaxed); }
+
+// record, a finished span of an operation, dropped when not recording
+inline void record(const std::uint32_t operation, const std::uint64_t begin, const std::uint64_t end) noexcept {
+    detail::State& s = detail::state();
+    if (operation >= s.operation_count.load(std::memory_order_acquire)) return;
+    s.histograms[operation]->add(end - begin);
+    if (!s.spans.load(std::memory_order_relaxed)) return;
+    detail::ThreadBuffer* buffer;
+    try {
+        buffer = detail::thread_buffer();
+    } catch (...) {
+        return;
+    }
+    const std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    detail::Span& span = buffer->spans[head % buffer->spans.size()];
+    span.begin.store(begin, std::memory_order_relaxed);
+    span.end.store(end, std::memory_order_relaxed);
+    span.operation.store(operation, std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+// start, begins recording, the options apply to thread buffers created afterwards
+inline void start(const TraceOptions& options=TraceOptions()) {
+    detail::State& s = detail::state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.origin_ticks == 0) {
+            s.origin_time = std::chrono::steady_clock::now();
+            s.origin_ticks = ticks();
+        }
+    }
+    s.span_capacity.store(options.span_capacity);
+    s.spans.store(options.spans);
+    s.recording.store(true);
+}
+// stop
+inline void stop() noexcept { detail::state().recording.store(false); }
+
+// clear, drops every span and histogram count recorded so far
+inline void clear() {
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (auto& buffer : s.buffers) buffer->floor.store(buffer->head.load(std::memory_order_acquire));
+    for (std::size_t i=0; i<s.names.size(); ++i) s.histograms[i]->clear();
+    detail::recycle(s);
+}
+
+// ticks_per_ns, measured against steady_clock since start, waits until 1 ms has passed
+inline double ticks_per_ns() {
+#ifdef DQPOSE_TRACE_TSC
+    detail::State& s = detail::state();
+    if (s.origin_ticks == 0) {
+        throw std::runtime_error("Error: trace::ticks_per_ns() Tracing was never started.");
+    }
+    auto elapsed = std::chrono::steady_clock::now() - s.origin_time;
+    if (elapsed < std::chrono::milliseconds(1)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1) - elapsed);
+    }
+    const std::uint64_t now = ticks();
+    elapsed = std::chrono::steady_clock::now() - s.origin_time;
+    return static_cast<double>(now - s.origin_ticks) / static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+#else
+    return 1;
+#endif
+}
+
+// summaries, the latency percentiles of every operation seen since the last clear
+inline std::vector<OperationSummary> summaries() {
+    const double scale = 1 / ticks_per_ns();
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::vector<OperationSummary> result;
+    for (std::size_t i=0; i<s.names.size(); ++i) {
+        const Histogram& h = *s.histograms[i];
+        const std::uint64_t count = h.count();
+        if (count == 0) continue;
+        result.push_back({ s.names[i], count, h.percentile(0.5) * scale, h.percentile(0.99) * scale,
+                           h.percentile(0.999) * scale, static_cast<double>(h.max()) * scale });
+    }
+    return result;
+}
+
+// histogram, of a named operation in ticks, null if it never ran
+inline const Histogram* histogram(const std::string& name) {
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (std::size_t i=0; i<s.names.size(); ++i) {
+        if (s.names[i] == name) return s.histograms[i].get();
+    }
+    return nullptr;
+}
+
+// write_chrome_trace, the retained spans as Chrome trace JSON, complete events in microseconds since start,
+// returns the number of spans written, spans overwritten while exporting are skipped,
+// the spans of exited threads are written once and their buffers then reused
+inline std::size_t write_chrome_trace(const std::string& path) {
+    const double scale = 1e-3 / ticks_per_ns();
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        throw std::runtime_error("Error: trace::write_chrome_trace() Cannot open " + path + ".");
+    }
+    std::size_t written = 0;
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (const auto& buffer : s.buffers) {
+        const std::uint64_t capacity = buffer->spans.size();
+        const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const std::uint64_t first = std::max(buffer->floor.load(), head > capacity ? head - capacity : 0);
+        for (std::uint64_t i=first; i<head; ++i) {
+            const detail::Span& span = buffer->spans[i % capacity];
+            const std::uint64_t begin = span.begin.load(std::memory_order_relaxed);
+            const std::uint64_t end = span.end.load(std::memory_order_relaxed);
+            const std::uint32_t operation = span.operation.load(std::memory_order_relaxed);
+            // the producer has lapped this slot since head was read
+            if (buffer->head.load(std::memory_order_acquire) >= i + capacity) continue;
+            if (operation >= s.names.size() || begin < s.origin_ticks) continue;
+            std::fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"dqpose\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         written == 0 ? "" : ",", s.names[operation].c_str(), buffer->thread,
+                         static_cast<double>(begin - s.origin_ticks) * scale, static_cast<double>(end - begin) * scale);
+            ++written;
+        }
+        if (buffer->retired) buffer->floor.store(head);
+    }
+    detail::recycle(s);
+    std::fprintf(file, "\n]}\n");
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        throw std::runtime_error("Error: trace::write_chrome_trace() Failed writing " + path + ".");
+    }
+    return written;
+}
+
+// Scope, times its lifetime as one span of an operation
+class Scope {
+protected:
+    std::uint32_t _operation;
+    std::uint64_t _begin;
+public:
+    explicit Scope(const std::uint32_t operation) noexcept
+        : _operation( operation ), _begin( recording() ? ticks() : 0 ) { }
+    ~Scope() {
+        if (_begin != 0) record(_operation, _begin, ticks());
+    }
+    Scope(const Scope&)=delete;
+    Scope& operator=(const Scope&)=delete;
+};
+
+}  // namespace trace
+
+}  // namespace dqpose
+
+#include "trace_macros.hpp"
@@ -0,0 +1,52 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose/trace_macros.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining the tracing macros of the library entry points
+ *
+ *     This file is what the library headers include to emit spans. Only when
+ *     DQPOSE_TRACE is defined does it include trace.hpp, with its threads,
+ *     atomics and buffers; otherwise DQPOSE_TRACE_SCOPE expands to nothing and
+ *     a translation unit pays for no part of the tracing.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#ifdef DQPOSE_TRACE
+#include "trace.hpp"
+#endif
+
+#define DQPOSE_TRACE_CONCAT_(a, b) a##b
+#define DQPOSE_TRACE_CONCAT(a, b) DQPOSE_TRACE_CONCAT_(a, b)
+
+#ifdef DQPOSE_TRACE
+// DQPOSE_TRACE_SCOPE, a span from here to the end of the enclosing block, name is a string literal
+#define DQPOSE_TRACE_SCOPE(name) \
+    static const std::uint32_t DQPOSE_TRACE_CONCAT(dqpose_trace_operation_, __LINE__) = ::dqpose::trace::operation(name); \
+    const ::dqpose::trace::Scope DQPOSE_TRACE_CONCAT(dqpose_trace_scope_, __LINE__)(DQPOSE_TRACE_CONCAT(dqpose_trace_operation_, __LINE__))
+// DQPOSE_TRACE_CONSTEXPR, constexpr unless the function holds a span, which C++20 forbids in constant expressions
+#define DQPOSE_TRACE_CONSTEXPR
+#else
+#define DQPOSE_TRACE_SCOPE(name) static_cast<void>(0)
+#define DQPOSE_TRACE_CONSTEXPR constexpr
+#endif
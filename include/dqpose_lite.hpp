@@ -0,0 +1,45 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file include/dqpose_lite.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief A header file defining the core pose types without iostream
+ *
+ *     This file provides the Quaternion, Dual Quaternion, pose, batch and
+ *     chain headers with DQPOSE_NO_IOSTREAM defined, so neither <iostream>
+ *     nor its static initializers are pulled in. to_string stays available,
+ *     operator<< does not. It must come before any other dqpose header of
+ *     the translation unit, or define DQPOSE_NO_IOSTREAM for the whole
+ *     target instead.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#ifndef DQPOSE_NO_IOSTREAM
+#define DQPOSE_NO_IOSTREAM
+#endif
+#include "dqpose/half.hpp"
+#include "dqpose/quat.hpp"
+#include "dqpose/dualquat.hpp"
+#include "dqpose/pose.hpp"
+#include "dqpose/batch.hpp"
+#include "dqpose/chain.hpp"
@@ -0,0 +1,208 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dispatch.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The selection and public entry points of the dispatched kernels
+ *
+ *     This file checks the CPU once, on the first call, for the best
+ *     supported kernel table, keeps it behind an atomic pointer and forwards
+ *     the batch calls to it after checking sizes and resizing outputs.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dqpose/dispatch.hpp"
+#include "dispatch_table.hpp"
+#include <atomic>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace dqpose
+{
+
+namespace
+{
+
+const dispatch::KernelTable* table_of(const Isa isa) noexcept {
+    switch (isa) {
+#ifdef DQPOSE_DISPATCH_X86
+        case Isa::AVX512: return &dispatch::avx512_table;
+        case Isa::AVX2: return &dispatch::avx2_table;
+#endif
+        default: return &dispatch::generic_table;
+    }
+}
+
+Isa best_isa() noexcept {
+    if (isa_supported(Isa::AVX512)) return Isa::AVX512;
+    if (isa_supported(Isa::AVX2)) return Isa::AVX2;
+    return Isa::Generic;
+}
+
+// -1 until the first call selects the best supported variant
+std::atomic<int> active{ -1 };
+
+template<typename Scalar>
+const dispatch::Kernels<Scalar>& kernels() noexcept {
+    const dispatch::KernelTable* table = table_of(active_isa());
+    if constexpr (std::is_same_v<Scalar, float>) return table->f;
+    else return table->d;
+}
+
+}  // namespace
+
+const char* isa_name(const Isa isa) noexcept {
+    switch (isa) {
+        case Isa::AVX512: return "avx512";
+        case Isa::AVX2: return "avx2";
+        default: return "generic";
+    }
+}
+
+bool isa_supported(const Isa isa) noexcept {
+    switch (isa) {
+        case Isa::Generic: return true;
+#ifdef DQPOSE_DISPATCH_X86
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+        default: return false;
+    }
+}
+
+Isa active_isa() noexcept {
+    int isa = active.load(std::memory_order_acquire);
+    if (isa < 0) {
+        // racing first calls select the same variant
+        isa = static_cast<int>(best_isa());
+        active.store(isa, std::memory_order_release);
+    }
+    return static_cast<Isa>(isa);
+}
+
+void force_isa(const Isa isa) {
+    if (!isa_supported(isa)) {
+        throw std::runtime_error(std::string("Error: force_isa() The CPU does not support ") + isa_name(isa) + ".");
+    }
+    active.store(static_cast<int>(isa), std::memory_order_release);
+}
+
+namespace dispatch
+{
+
+namespace
+{
+
+template<typename Scalar, typename Batch>
+std::array<const Scalar*, 8> components(const Batch& batch, const int count) noexcept {
+    std::array<const Scalar*, 8> pointers{ };
+    for (int k=0; k<count; ++k) pointers[k] = batch.data(k);
+    return pointers;
+}
+
+template<typename Scalar, typename Batch>
+std::array<Scalar*, 8> components(Batch& batch, const int count) noexcept {
+    std::array<Scalar*, 8> pointers{ };
+    for (int k=0; k<count; ++k) pointers[k] = batch.data(k);
+    return pointers;
+}
+
+template<typename Scalar>
+void multiply_impl(const DualQuatBatch<Scalar>& a, const DualQuatBatch<Scalar>& b, DualQuatBatch<Scalar>& out) {
+    DQPOSE_TRACE_SCOPE("dqpose::dispatch::multiply");
+    if (a.size() != b.size()) {
+        throw std::runtime_error("Error: dispatch::multiply() Batches differ in size.");
+    }
+    // resizing out when it aliases a or b keeps their size, and so their data
+    out.resize(a.size());
+    const auto x = components<Scalar>(a, 8);
+    const auto y = components<Scalar>(b, 8);
+    const auto z = components<Scalar>(out, 8);
+    kernels<Scalar>().multiply(x.data(), y.data(), z.data(), a.size());
+}
+
+template<typename Scalar>
+void transform_impl(const DualQuat<Scalar>& pose, PureQuatBatch<Scalar>& points) {
+    DQPOSE_TRACE_SCOPE("dqpose::dispatch::transform");
+    const std::array<Scalar, 8> dq = pose.array();
+    const auto p = components<Scalar>(points, 3);
+    kernels<Scalar>().transform(dq.data(), p.data(), points.size());
+}
+
+template<typename Scalar>
+void normalize_impl(QuatBatch<Scalar>& batch, const NormalizeMethod method) {
+    DQPOSE_TRACE_SCOPE("dqpose::dispatch::normalize");
+    const auto p = components<Scalar>(batch, 4);
+    kernels<Scalar>().normalize_quat(p.data(), batch.size(), method);
+}
+
+template<typename Scalar>
+void normalize_impl(DualQuatBatch<Scalar>& batch, const NormalizeMethod method) {
+    DQPOSE_TRACE_SCOPE("dqpose::dispatch::normalize");
+    const auto p = components<Scalar>(batch, 8);
+    kernels<Scalar>().normalize(p.data(), batch.size(), method);
+}
+
+template<typename Scalar>
+void screw_log_impl(const DualQuatBatch<Scalar>& poses, PureQuatBatch<Scalar>& real, PureQuatBatch<Scalar>& dual) {
+    DQPOSE_TRACE_SCOPE("dqpose::dispatch::screw_log");
+    real.resize(poses.size());
+    dual.resize(poses.size());
+    const auto x = components<Scalar>(poses, 8);
+    std::array<Scalar*, 8> v{ real.data(0), real.data(1), real.data(2), dual.data(0), dual.data(1), dual.data(2) };
+    kernels<Scalar>().screw_log(x.data(), v.data(), poses.size());
+}
+
+template<typename Scalar>
+void screw_exp_impl(const PureQuatBatch<Scalar>& real, const PureQuatBatch<Scalar>& dual, DualQuatBatch<Scalar>& poses) {
+    DQPOSE_TRACE_SCOPE("dqpose::dispatch::screw_exp");
+    if (real.size() != dual.size()) {
+        throw std::runtime_error("Error: dispatch::screw_exp() Real and dual batches differ in size.");
+    }
+    poses.resize(real.size());
+    const std::array<const Scalar*, 8> v{ real.data(0), real.data(1), real.data(2), dual.data(0), dual.data(1), dual.data(2) };
+    const auto x = components<Scalar>(poses, 8);
+    kernels<Scalar>().screw_exp(v.data(), x.data(), real.size());
+}
+
+}  // namespace
+
+void multiply(const DualQuatBatch<float>& a, const DualQuatBatch<float>& b, DualQuatBatch<float>& out) { multiply_impl(a, b, out); }
+void multiply(const DualQuatBatch<double>& a, const DualQuatBatch<double>& b, DualQuatBatch<double>& out) { multiply_impl(a, b, out); }
+void transform(const DualQuat<float>& pose, PureQuatBatch<float>& points) { transform_impl(pose, points); }
+void transform(const DualQuat<double>& pose, PureQuatBatch<double>& points) { transform_impl(pose, points); }
+void normalize(QuatBatch<float>& batch, const NormalizeMethod method) { normalize_impl(batch, method); }
+void normalize(QuatBatch<double>& batch, const NormalizeMethod method) { normalize_impl(batch, method); }
+void normalize(DualQuatBatch<float>& batch, const NormalizeMethod method) { normalize_impl(batch, method); }
+void normalize(DualQuatBatch<double>& batch, const NormalizeMethod method) { normalize_impl(batch, method); }
+void screw_log(const DualQuatBatch<float>& poses, PureQuatBatch<float>& real, PureQuatBatch<float>& dual) { screw_log_impl(poses, real, dual); }
+void screw_log(const DualQuatBatch<double>& poses, PureQuatBatch<double>& real, PureQuatBatch<double>& dual) { screw_log_impl(poses, real, dual); }
+void screw_exp(const PureQuatBatch<float>& real, const PureQuatBatch<float>& dual, DualQuatBatch<float>& poses) { screw_exp_impl(real, dual, poses); }
+void screw_exp(const PureQuatBatch<double>& real, const PureQuatBatch<double>& dual, DualQuatBatch<double>& poses) { screw_exp_impl(real, dual, poses); }
+
+}  // namespace dispatch
+
+}  // namespace dqpose
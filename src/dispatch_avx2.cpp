@@ -0,0 +1,103 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dispatch_avx2.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The AVX2 variant of the dispatched kernels
+ *
+ *     This file compiles the kernels for AVX2 with FMA, picked on x86 CPUs
+ *     reporting both. Fast normalization refines vrsqrtps by Newton-Raphson.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dispatch_table.hpp"
+
+#ifdef DQPOSE_DISPATCH_X86
+#include <immintrin.h>
+#include <limits>
+
+namespace dqpose
+{
+
+namespace dispatch
+{
+
+namespace
+{
+
+// rsqrt_block, vrsqrtps, relative error below 1.5 2^-12, and one Newton-Raphson step, 2.1e-7 plus rounding;
+// blocks holding a value outside of the normal floats, which vrsqrtps flushes, take kernel::rsqrt as the other variants
+__attribute__((target("avx2,fma"))) inline void rsqrt_block(float* x, const std::size_t count) noexcept {
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_halves = _mm256_set1_ps(1.5f);
+    const __m256 lowest = _mm256_set1_ps(std::numeric_limits<float>::min());
+    const __m256 highest = _mm256_set1_ps(std::numeric_limits<float>::max());
+    std::size_t i = 0;
+    for (; i+8<=count; i+=8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256 normal = _mm256_and_ps(_mm256_cmp_ps(v, lowest, _CMP_GE_OQ), _mm256_cmp_ps(v, highest, _CMP_LE_OQ));
+        if (_mm256_movemask_ps(normal) != 0xFF) {
+            for (std::size_t k=i; k<i+8; ++k) x[k] = kernel::rsqrt(x[k]);
+            continue;
+        }
+        const __m256 y = _mm256_rsqrt_ps(v);
+        const __m256 half_v_y = _mm256_mul_ps(_mm256_mul_ps(half, v), y);
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(y, _mm256_fnmadd_ps(half_v_y, y, three_halves)));
+    }
+    for (; i<count; ++i) x[i] = kernel::rsqrt(x[i]);
+}
+// rsqrt_block, vrsqrtps on the values rounded to float and three Newton-Raphson steps in double; blocks holding a
+// value outside of the normal floats, which the rounding to float overflows or flushes, take kernel::rsqrt
+__attribute__((target("avx2,fma"))) inline void rsqrt_block(double* x, const std::size_t count) noexcept {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_halves = _mm256_set1_pd(1.5);
+    const __m256d lowest = _mm256_set1_pd(std::numeric_limits<float>::min());
+    const __m256d highest = _mm256_set1_pd(std::numeric_limits<float>::max());
+    std::size_t i = 0;
+    for (; i+4<=count; i+=4) {
+        const __m256d v = _mm256_loadu_pd(x + i);
+        const __m256d normal = _mm256_and_pd(_mm256_cmp_pd(v, lowest, _CMP_GE_OQ), _mm256_cmp_pd(v, highest, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(normal) != 0xF) {
+            for (std::size_t k=i; k<i+4; ++k) x[k] = kernel::rsqrt(x[k]);
+            continue;
+        }
+        const __m256d half_v = _mm256_mul_pd(half, v);
+        __m256d y = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(v)));
+        for (int step=0; step<3; ++step) {
+            y = _mm256_mul_pd(y, _mm256_fnmadd_pd(_mm256_mul_pd(half_v, y), y, three_halves));
+        }
+        _mm256_storeu_pd(x + i, y);
+    }
+    for (; i<count; ++i) x[i] = kernel::rsqrt(x[i]);
+}
+
+}  // namespace
+
+}  // namespace dispatch
+
+}  // namespace dqpose
+
+#define DQPOSE_DISPATCH_TARGET __attribute__((target("avx2,fma")))
+#define DQPOSE_DISPATCH_TABLE avx2_table
+#include "dispatch_kernels.ipp"
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dispatch_avx512.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The AVX-512 variant of the dispatched kernels
+ *
+ *     This file compiles the kernels for AVX-512F on top of AVX2 with FMA,
+ *     picked on x86 CPUs reporting all three. Fast normalization refines
+ *     vrsqrt14ps and vrsqrt14pd by Newton-Raphson.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dispatch_table.hpp"
+
+#ifdef DQPOSE_DISPATCH_X86
+#include <immintrin.h>
+#include <limits>
+
+namespace dqpose
+{
+
+namespace dispatch
+{
+
+namespace
+{
+
+// rsqrt_block, vrsqrt14ps, relative error below 2^-14, and one Newton-Raphson step; blocks holding a value outside
+// of the normal floats take kernel::rsqrt as the other variants
+__attribute__((target("avx512f,avx2,fma"))) inline void rsqrt_block(float* x, const std::size_t count) noexcept {
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 three_halves = _mm512_set1_ps(1.5f);
+    const __m512 lowest = _mm512_set1_ps(std::numeric_limits<float>::min());
+    const __m512 highest = _mm512_set1_ps(std::numeric_limits<float>::max());
+    std::size_t i = 0;
+    for (; i+16<=count; i+=16) {
+        const __m512 v = _mm512_loadu_ps(x + i);
+        if ((_mm512_cmp_ps_mask(v, lowest, _CMP_GE_OQ) & _mm512_cmp_ps_mask(v, highest, _CMP_LE_OQ)) != 0xFFFF) {
+            for (std::size_t k=i; k<i+16; ++k) x[k] = kernel::rsqrt(x[k]);
+            continue;
+        }
+        const __m512 y = _mm512_maskz_rsqrt14_ps(0xFFFF, v);
+        const __m512 half_v_y = _mm512_mul_ps(_mm512_mul_ps(half, v), y);
+        _mm512_storeu_ps(x + i, _mm512_mul_ps(y, _mm512_fnmadd_ps(half_v_y, y, three_halves)));
+    }
+    for (; i<count; ++i) x[i] = kernel::rsqrt(x[i]);
+}
+// rsqrt_block, vrsqrt14pd and two Newton-Raphson steps; blocks holding a value outside of the normal doubles take
+// kernel::rsqrt as the other variants
+__attribute__((target("avx512f,avx2,fma"))) inline void rsqrt_block(double* x, const std::size_t count) noexcept {
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_halves = _mm512_set1_pd(1.5);
+    const __m512d lowest = _mm512_set1_pd(std::numeric_limits<double>::min());
+    const __m512d highest = _mm512_set1_pd(std::numeric_limits<double>::max());
+    std::size_t i = 0;
+    for (; i+8<=count; i+=8) {
+        const __m512d v = _mm512_loadu_pd(x + i);
+        if ((_mm512_cmp_pd_mask(v, lowest, _CMP_GE_OQ) & _mm512_cmp_pd_mask(v, highest, _CMP_LE_OQ)) != 0xFF) {
+            for (std::size_t k=i; k<i+8; ++k) x[k] = kernel::rsqrt(x[k]);
+            continue;
+        }
+        const __m512d half_v = _mm512_mul_pd(half, v);
+        __m512d y = _mm512_maskz_rsqrt14_pd(0xFF, v);
+        for (int step=0; step<2; ++step) {
+            y = _mm512_mul_pd(y, _mm512_fnmadd_pd(_mm512_mul_pd(half_v, y), y, three_halves));
+        }
+        _mm512_storeu_pd(x + i, y);
+    }
+    for (; i<count; ++i) x[i] = kernel::rsqrt(x[i]);
+}
+
+}  // namespace
+
+}  // namespace dispatch
+
+}  // namespace dqpose
+
+#define DQPOSE_DISPATCH_TARGET __attribute__((target("avx512f,avx2,fma")))
+#define DQPOSE_DISPATCH_TABLE avx512_table
+#include "dispatch_kernels.ipp"
+
+#endif
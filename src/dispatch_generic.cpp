@@ -0,0 +1,57 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dispatch_generic.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The generic variant of the dispatched kernels
+ *
+ *     This file compiles the kernels for the baseline instruction set of the
+ *     build, the fallback on every CPU. Fast normalization uses kernel::rsqrt.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dispatch_table.hpp"
+
+namespace dqpose
+{
+
+namespace dispatch
+{
+
+namespace
+{
+
+// rsqrt_block, kernel::rsqrt of count values in place
+template<typename Scalar>
+inline void rsqrt_block(Scalar* x, const std::size_t count) noexcept {
+    for (std::size_t i=0; i<count; ++i) x[i] = kernel::rsqrt(x[i]);
+}
+
+}  // namespace
+
+}  // namespace dispatch
+
+}  // namespace dqpose
+
+#define DQPOSE_DISPATCH_TARGET
+#define DQPOSE_DISPATCH_TABLE generic_table
+#include "dispatch_kernels.ipp"
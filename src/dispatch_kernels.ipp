@@ -0,0 +1,122 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dispatch_kernels.ipp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The SoA kernels shared by every instruction set translation unit
+ *
+ *     Included once per translation unit after defining DQPOSE_DISPATCH_TARGET,
+ *     the function attribute selecting the instruction set,
+ *     DQPOSE_DISPATCH_TABLE, the name of the KernelTable to define, and the
+ *     rsqrt_block functions of the unit. The loops run over the component
+ *     arrays so the compiler vectorizes them for the target, the header
+ *     kernels they call are flattened into the attributed functions while any
+ *     out of line copy stays generic, which keeps the variants free of ODR
+ *     clashes.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dispatch_table.hpp"
+#include "dqpose/kernel.hpp"
+#include <cmath>
+
+namespace dqpose
+{
+
+namespace dispatch
+{
+
+#if defined(__GNUC__)
+#define DQPOSE_DISPATCH_FLATTEN __attribute__((flatten))
+#else
+#define DQPOSE_DISPATCH_FLATTEN
+#endif
+
+namespace
+{
+
+template<typename Scalar>
+DQPOSE_DISPATCH_TARGET DQPOSE_DISPATCH_FLATTEN void multiply(const Scalar* const* a, const Scalar* const* b, Scalar* const* out, const std::size_t size) {
+    for (std::size_t i=0; i<size; ++i) {
+        Scalar x[8], y[8];
+        for (int k=0; k<8; ++k) {
+            x[k] = a[k][i];
+            y[k] = b[k][i];
+        }
+        kernel::dualquat_mul(x, y, x);
+        for (int k=0; k<8; ++k) out[k][i] = x[k];
+    }
+}
+
+template<typename Scalar>
+DQPOSE_DISPATCH_TARGET DQPOSE_DISPATCH_FLATTEN void transform(const Scalar* pose8, Scalar* const* points, const std::size_t size) {
+    Scalar t[3];
+    kernel::dualquat_translation(pose8, t);
+    Scalar* x = points[0];
+    Scalar* y = points[1];
+    Scalar* z = points[2];
+    for (std::size_t i=0; i<size; ++i) {
+        Scalar v[3] = { x[i], y[i], z[i] };
+        kernel::quat_rotate(pose8, v, v);
+        x[i] = v[0] + t[0]; y[i] = v[1] + t[1]; z[i] = v[2] + t[2];
+    }
+}
+
+// normalize_soa, kernel::normalize_soa with the Fast factors from the rsqrt_block of the unit
+template<int Components, typename Scalar>
+DQPOSE_DISPATCH_TARGET DQPOSE_DISPATCH_FLATTEN void normalize_soa(Scalar* const* data, const std::size_t size, const NormalizeMethod method) {
+    kernel::normalize_soa<Components, Scalar>(data, size, method, [](Scalar* norm2, const std::size_t count, const NormalizeMethod m) {
+        if (m == NormalizeMethod::Fast) rsqrt_block(norm2, count);
+        else kernel::normalize_factors(norm2, count, m);
+    });
+}
+
+template<typename Scalar>
+DQPOSE_DISPATCH_TARGET DQPOSE_DISPATCH_FLATTEN void screw_log(const Scalar* const* dq, Scalar* const* v6, const std::size_t size) {
+    for (std::size_t i=0; i<size; ++i) {
+        Scalar x[8], v[6];
+        for (int k=0; k<8; ++k) x[k] = dq[k][i];
+        kernel::unit_dualquat_log(x, v);
+        for (int k=0; k<6; ++k) v6[k][i] = v[k];
+    }
+}
+
+template<typename Scalar>
+DQPOSE_DISPATCH_TARGET DQPOSE_DISPATCH_FLATTEN void screw_exp(const Scalar* const* v6, Scalar* const* dq, const std::size_t size) {
+    for (std::size_t i=0; i<size; ++i) {
+        Scalar v[6], x[8];
+        for (int k=0; k<6; ++k) v[k] = v6[k][i];
+        kernel::pure_dualquat_exp(v, x);
+        for (int k=0; k<8; ++k) dq[k][i] = x[k];
+    }
+}
+
+}  // namespace
+
+const KernelTable DQPOSE_DISPATCH_TABLE = {
+    { multiply<float>, transform<float>, normalize_soa<4, float>, normalize_soa<8, float>, screw_log<float>, screw_exp<float> },
+    { multiply<double>, transform<double>, normalize_soa<4, double>, normalize_soa<8, double>, screw_log<double>, screw_exp<double> },
+};
+
+}  // namespace dispatch
+
+}  // namespace dqpose
@@ -0,0 +1,76 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dispatch_table.hpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The private kernel tables of the runtime dispatch
+ *
+ *     Every instruction set translation unit defines one KernelTable of
+ *     SoA kernels over the raw component arrays of the batches, src/dispatch.cpp
+ *     picks one of them and forwards the public calls to it.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#pragma once
+#include "dqpose/kernel.hpp"
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DQPOSE_DISPATCH_X86 1
+#endif
+
+namespace dqpose
+{
+
+namespace dispatch
+{
+
+template<typename Scalar>
+struct Kernels {
+    // out[k][i] = (a b)[k][i] over 8 components, out may alias a or b
+    void (*multiply)(const Scalar* const* a, const Scalar* const* b, Scalar* const* out, std::size_t size);
+    // points[k][i] = (r p r* + t)[k][i] over 3 components, pose8 is the unit Dual Quaternion
+    void (*transform)(const Scalar* pose8, Scalar* const* points, std::size_t size);
+    // q[k][i] scaled to |q| = 1 over 4 components
+    void (*normalize_quat)(Scalar* const* q, std::size_t size, NormalizeMethod method);
+    // dq[k][i] projected onto the unit Dual Quaternions over 8 components
+    void (*normalize)(Scalar* const* dq, std::size_t size, NormalizeMethod method);
+    // v6[k][i] = log(dq)[k][i], 8 components in, 6 out
+    void (*screw_log)(const Scalar* const* dq, Scalar* const* v6, std::size_t size);
+    // dq[k][i] = exp(v6)[k][i], 6 components in, 8 out
+    void (*screw_exp)(const Scalar* const* v6, Scalar* const* dq, std::size_t size);
+};
+
+struct KernelTable {
+    Kernels<float> f;
+    Kernels<double> d;
+};
+
+extern const KernelTable generic_table;
+#ifdef DQPOSE_DISPATCH_X86
+extern const KernelTable avx2_table;
+extern const KernelTable avx512_table;
+#endif
+
+}  // namespace dispatch
+
+}  // namespace dqpose
@@ -0,0 +1,70 @@
+/**
+ *     This file is part of dqpose.
+ *
+ *     dqpose is free software: you can redistribute it and/or modify
+ *     it under the terms of the GNU General Public License as published
+ *     by the Free Software Foundation, either version 3 of the License,
+ *     or (at your option) any later version.
+ *
+ *     dqpose is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *     See the GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with dqpose. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ *     \file src/dqpose.cpp
+ *	   \author Jiawei ZHAO
+ *	   \version 1.0
+ *	   \date 2024-2025
+ *
+ *     \brief The explicit instantiations of the dqpose library
+ *
+ *     This file instantiates the classes for float, double and long double,
+ *     and the chain routines for the common scalar pairs, once. Targets
+ *     linking the dqpose library see the matching extern template
+ *     declarations through DQPOSE_USE_LIBRARY and skip instantiating them.
+ *
+ *     \cite https://github.com/zhaojiawei392/dqpose.git
+ */
+
+#include "dqpose/quat.hpp"
+#include "dqpose/dualquat.hpp"
+#include "dqpose/pose.hpp"
+#include "dqpose/batch.hpp"
+#include "dqpose/chain.hpp"
+
+namespace dqpose
+{
+
+#define DQPOSE_INSTANTIATE(Scalar) \
+    template class Quat<Scalar>; \
+    template class PureQuat<Scalar>; \
+    template class UnitQuat<Scalar>; \
+    template class UnitPureQuat<Scalar>; \
+    template class DualQuat<Scalar>; \
+    template class PureDualQuat<Scalar>; \
+    template class UnitDualQuat<Scalar>; \
+    template class UnitPureDualQuat<Scalar>; \
+    template class Rotation<Scalar>; \
+    template class Translation<Scalar>; \
+    template class UnitAxis<Scalar>; \
+    template class Pose<Scalar>; \
+    template class QuatBatch<Scalar>; \
+    template class PureQuatBatch<Scalar>; \
+    template class DualQuatBatch<Scalar>;
+DQPOSE_INSTANTIATE(float)
+DQPOSE_INSTANTIATE(double)
+DQPOSE_INSTANTIATE(long double)
+#undef DQPOSE_INSTANTIATE
+
+template class RenormPolicy<double>;
+template Pose<double> compose<double, float>(const DualQuatBatch<float>&, const RenormPolicy<double>&);
+template Pose<double> compose<double, double>(const DualQuatBatch<double>&, const RenormPolicy<double>&);
+template void accumulate<double, float, float>(const DualQuatBatch<float>&, DualQuatBatch<float>&, const Pose<double>&, const RenormPolicy<double>&);
+template void accumulate<double, double, double>(const DualQuatBatch<double>&, DualQuatBatch<double>&, const Pose<double>&, const RenormPolicy<double>&);
+
+}  // namespace dqpose